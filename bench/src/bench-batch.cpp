@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       bench-batch.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache benchmarks (batch rendering scalability).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "bench.hpp"
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <sstream>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include "../../src/mustache-light.hpp"
+using mustache::Engine;
+using mustache::TemplatePtr;
+using mustache::ThreadPool;
+using mustache::BatchRenderer;
+
+// Renders the fixture (view and context with the same name) against many
+// copies of its context, with 1, 2, 4, ... threads.
+static void batchScaling(const string& fixture, std::size_t count) {
+    const Engine engine(bench::fixturesPath());
+    const TemplatePtr view = engine.load(fixture);
+    const json base = json::parse(engine.fileRead(fixture, "json"));
+    vector<json> contexts(count, base);
+    vector<string> outputs;
+
+    unsigned maxThreads = std::thread::hardware_concurrency();
+    if (maxThreads == 0) {
+        maxThreads = 1;
+    }
+    double singleThread = 0.0;
+    for (unsigned threads = 1; ; threads *= 2) {
+        if (threads > maxThreads) {
+            threads = maxThreads;
+        }
+        ThreadPool pool(threads);
+        BatchRenderer batch(engine, pool);
+        std::size_t bytes = 0;
+        bench::Measure measure = bench::measure([&]() {
+            batch.render(*view, contexts, outputs);
+        });
+        for (std::size_t i = 0; i < outputs.size(); ++i) {
+            bytes += outputs[i].size();
+        }
+        const double perBatch = measure.seconds / measure.iterations;
+        if (threads == 1) {
+            singleThread = perBatch;
+        }
+        std::ostringstream notes;
+        notes.precision(2);
+        notes << std::fixed << count / perBatch << " renders/s, speedup "
+              << singleThread / perBatch << "x";
+        bench::report(fixture + " x" + std::to_string(count) + " threads=" +
+                      std::to_string(threads), measure, bytes, notes.str());
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+}
+
+static void batch() {
+    batchScaling("partials/multiple-partials-with-variables", 20000);
+    batchScaling("templates/basic-template", 20000);
+    batchScaling("sections/list-special-variables", 20000);
+}
+BENCHMARK("batch", batch);
+
+////////////////////////////////////////////////////////////////////////////////
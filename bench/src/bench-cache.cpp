@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       bench-cache.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache benchmarks (template cache contention).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "bench.hpp"
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <map>
+#include <mutex>
+#include <thread>
+#include <sstream>
+#include <cstdlib>
+
+#include "../../src/mustache-light.hpp"
+using mustache::Engine;
+using mustache::TemplateCache;
+using mustache::TemplatePtr;
+
+// The cache used before TemplateCache: a map protected by a mutex.
+class LockedCache {
+  public:
+    TemplatePtr find(const string& key) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<string, TemplatePtr>::const_iterator it = map_.find(key);
+        return (it == map_.end()) ? TemplatePtr() : it->second;
+    }
+
+    void insert(const string& key, const TemplatePtr& compiled) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        map_.insert(std::make_pair(key, compiled));
+    }
+
+  private:
+    mutable std::mutex mutex_;
+    std::map<string, TemplatePtr> map_;
+};
+
+static const std::size_t KEYS = 64;
+static const std::size_t LOOKUPS = 1000000;
+
+// Runs LOOKUPS lookups split among readers threads, like the {{> }} tags
+// of many concurrent renders.
+template <class Cache>
+static void contention(const string& name, const Cache& cache,
+                       const vector<string>& keys) {
+    double singleThread = 0.0;
+    for (unsigned readers = 1; readers <= 64; readers *= 2) {
+        bench::Measure measure = bench::measure([&]() {
+            vector<std::thread> threads;
+            for (unsigned t = 0; t < readers; ++t) {
+                threads.push_back(std::thread([&cache, &keys, readers, t]() {
+                    for (std::size_t i = t; i < LOOKUPS; i += readers) {
+                        if (!cache.find(keys[i % KEYS])) {
+                            std::abort();
+                        }
+                    }
+                }));
+            }
+            for (std::size_t t = 0; t < threads.size(); ++t) {
+                threads[t].join();
+            }
+        });
+        const double perRun = measure.seconds / measure.iterations;
+        if (readers == 1) {
+            singleThread = perRun;
+        }
+        std::ostringstream notes;
+        notes.precision(2);
+        notes << std::fixed << LOOKUPS / perRun / 1e6 << " M lookups/s, speedup "
+              << singleThread / perRun << "x";
+        bench::report(name + " readers=" + std::to_string(readers), measure, 0,
+                      notes.str());
+    }
+}
+
+static void cache() {
+    const Engine engine(bench::fixturesPath());
+    const TemplatePtr compiled = engine.load("partials/common/user");
+
+    vector<string> keys;
+    TemplateCache lockFree;
+    LockedCache locked;
+    for (std::size_t i = 0; i < KEYS; ++i) {
+        keys.push_back("partials/common/user|Name='" + std::to_string(i) + "'");
+        lockFree.insert(keys.back(), compiled);
+        locked.insert(keys.back(), compiled);
+    }
+    contention("TemplateCache", lockFree, keys);
+    contention("mutex + std::map", locked, keys);
+}
+BENCHMARK("cache", cache);
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       bench-lookup.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache benchmarks (variable lookup in sparse contexts).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "bench.hpp"
+
+#include <string>
+using std::string;
+#include <sstream>
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include "../../src/mustache-light.hpp"
+using mustache::Engine;
+using mustache::Renderer;
+using mustache::TemplatePtr;
+
+static const unsigned FIELDS = 20;
+static const unsigned ROWS = 200;
+
+// A row template printing FIELDS optional fields, each one also used as a
+// section: rendered with contexts holding all, some or none of them.
+static void lookup() {
+    std::ostringstream view;
+    view << "{{# rows }}";
+    for (unsigned f = 0; f < FIELDS; ++f) {
+        view << "{{ field-" << f << " }}{{= field-" << f << " }}<b>{{/ field-" << f << " }}"
+             << "{{ items[" << f << "] }}";
+    }
+    view << "{{/ rows }}";
+    const Engine engine(bench::fixturesPath());
+    const TemplatePtr compiled = engine.compile(view.str());
+    Renderer renderer(engine);
+
+    for (unsigned present : { FIELDS, FIELDS / 4, 0u }) {
+        json context;
+        for (unsigned r = 0; r < ROWS; ++r) {
+            json row = json::object();
+            for (unsigned f = 0; f < present; ++f) {
+                row["field-" + std::to_string(f)] = "value";
+                row["items"].push_back(f);
+            }
+            context["rows"].push_back(row);
+        }
+        const bench::Measure measure = bench::measure([&]() {
+            renderer.render(*compiled, context);
+        });
+        const std::size_t lookups = static_cast<std::size_t>(ROWS) * FIELDS * 3;
+        std::ostringstream notes;
+        notes.precision(1);
+        notes << std::fixed << measure.seconds * 1e9 / measure.iterations / lookups
+              << " ns/lookup";
+        bench::report("lookup present=" + std::to_string(present) + "/" + std::to_string(FIELDS),
+                      measure, renderer.output().size(), notes.str());
+    }
+}
+BENCHMARK("lookup", lookup);
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       bench-render.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache benchmarks (tokenize, escape, sections, partials and
+///             full renders on fixtures scaled from test/fixtures).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "bench.hpp"
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <memory>
+#include <utility>
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include "../../src/mustache-light.hpp"
+using mustache::Engine;
+using mustache::EngineOptions;
+using mustache::Escape;
+using mustache::MemorySource;
+using mustache::Renderer;
+using mustache::Template;
+using mustache::TemplatePtr;
+
+// Renders the fixture (view and context with the same name) with its
+// context scaled to every size.
+static void renderScaled(const string& group, const string& fixture) {
+    const Engine engine(bench::fixturesPath());
+    const TemplatePtr view = engine.load(fixture);
+    const json base = json::parse(engine.fileRead(fixture, "json"));
+    Renderer renderer(engine);
+    // Without arrays all the sizes are the same
+    const bool scalable = bench::scaleContext(base, 2) != base;
+
+    for (const bench::Scale& scale : bench::scales()) {
+        if (scale.factor > 1 && !scalable) {
+            break;
+        }
+        const json context = bench::scaleContext(base, scale.factor);
+        const bench::Measure measure = bench::measure([&]() {
+            renderer.render(*view, context);
+        });
+        bench::report(group + " " + fixture + " " + scale.name, measure,
+                      renderer.output().size(), renderer.error());
+    }
+}
+
+// Compiles views made of some fixtures repeated for every size.
+static void tokenize() {
+    const Engine engine(bench::fixturesPath());
+    const string view = engine.fileRead("basic/simple-html") +
+                        engine.fileRead("sections/sections-with-data") +
+                        engine.fileRead("logic/nested") +
+                        engine.fileRead("partials/multiple-partials-with-variables");
+
+    for (const bench::Scale& scale : bench::scales()) {
+        const string scaled = bench::scaleText(view, scale.factor);
+        std::size_t tokens = 0;
+        const bench::Measure measure = bench::measure([&]() {
+            const Template compiled(scaled);
+            tokens = compiled.size();
+        });
+        bench::report(string("tokenize ") + scale.name, measure, scaled.size(),
+                      std::to_string(tokens) + " tokens");
+    }
+}
+BENCHMARK("tokenize", tokenize);
+
+// Escapes an HTML fixture with every escape policy.
+static void escape() {
+    const Engine engine(bench::fixturesPath());
+    const string text = engine.fileRead("basic/simple-html");
+    const std::pair<const char*, Escape> policies[] = {
+        { "html", Escape::Html },
+        { "html-attribute", Escape::HtmlAttribute },
+        { "json", Escape::Json },
+        { "csv", Escape::Csv },
+        { "url", Escape::Url },
+        { "none", Escape::None }
+    };
+
+    for (const bench::Scale& scale : bench::scales()) {
+        const string scaled = bench::scaleText(text, scale.factor);
+        string output;
+        for (const std::pair<const char*, Escape>& policy : policies) {
+            const mustache::EscapeFunction function = mustache::escapeFunction(policy.second);
+            const bench::Measure measure = bench::measure([&]() {
+                output.clear();
+                function(output, scaled.data(), scaled.size());
+            });
+            bench::report(string("escape ") + policy.first + " " + scale.name, measure,
+                          scaled.size());
+        }
+    }
+}
+BENCHMARK("escape", escape);
+
+// Sections over arrays growing with the size.
+static void sections() {
+    renderScaled("sections", "sections/list-special-variables");
+    renderScaled("sections", "sections/sections-with-data");
+}
+BENCHMARK("sections", sections);
+
+static const unsigned DEPTH = 8;
+
+// The nested partials fixture and a synthetic chain of DEPTH partials
+// (each one with its own parameters) rendered for every row.
+static void partials() {
+    renderScaled("partials", "partials/nested");
+
+    MemorySource::Files files;
+    files["page.mustache"] = "<ul>{{# rows }}<li>{{> level-0 | Depth='0' }}</li>{{/ rows }}</ul>";
+    for (unsigned level = 0; level < DEPTH; ++level) {
+        string view = "<b>{{ name }}</b> {{ Depth }}";
+        if (level + 1 < DEPTH) {
+            const string next = std::to_string(level + 1);
+            view += " {{> level-" + next + " | Depth='" + next + "' }}";
+        }
+        files["level-" + std::to_string(level) + ".mustache"] = view;
+    }
+    EngineOptions options;
+    options.source = std::make_shared<MemorySource>(files);
+    const Engine engine("", options);
+    const TemplatePtr view = engine.load("page");
+    Renderer renderer(engine);
+    const json row = { { "name", "row <name>" } };
+
+    for (const bench::Scale& scale : bench::scales()) {
+        const json context = { { "rows", bench::scaleContext(json::array({ row }), scale.factor * 10) } };
+        const bench::Measure measure = bench::measure([&]() {
+            renderer.render(*view, context);
+        });
+        bench::report(string("partials depth=") + std::to_string(DEPTH) + " " + scale.name,
+                      measure, renderer.output().size(), renderer.error());
+    }
+}
+BENCHMARK("partials", partials);
+
+// Full renders of the fixtures: variables, logic, partials and dynamic
+// templates together.
+static void render() {
+    renderScaled("render", "templates/basic-template");
+    renderScaled("render", "logic/nested");
+    renderScaled("render", "partials/multiple-partials-with-variables");
+    renderScaled("render", "sections/list");
+}
+BENCHMARK("render", render);
+
+////////////////////////////////////////////////////////////////////////////////
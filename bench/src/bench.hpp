@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       bench.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache benchmarks (common include).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+
+#include <nlohmann/json.hpp>
+
+namespace bench {
+
+/// A benchmark function.
+typedef void (*Function)();
+
+/// Registers a benchmark (use the BENCHMARK macro).
+struct Registrar {
+    Registrar(const char* name, Function function);
+};
+
+/// Registers function as benchmark name.
+#define BENCHMARK(name, function) \
+    static bench::Registrar registrar_##function(name, function)
+
+/// Result of a measure.
+struct Measure {
+    std::size_t iterations;
+    double seconds;
+    std::size_t allocations;    ///< operator new calls (all iterations)
+};
+
+/// Number of operator new calls since the program started (all threads).
+std::size_t allocations();
+
+/// Base path of the test fixtures.
+const std::string& fixturesPath();
+
+/// Size of the synthetic fixtures built from test/fixtures.
+struct Scale {
+    const char* name;
+    std::size_t factor;     ///< How many times arrays and views are repeated
+};
+
+/// Scales used by the benchmarks: small, medium and huge.
+const std::vector<Scale>& scales();
+
+/// Returns context with every array (at any depth) repeated factor times.
+nlohmann::json scaleContext(const nlohmann::json& context, std::size_t factor);
+
+/// Returns text repeated factor times.
+std::string scaleText(const std::string& text, std::size_t factor);
+
+/// Calls f until minSeconds are elapsed (at least once).
+template <class F>
+Measure measure(F f, double minSeconds = 0.5) {
+    typedef std::chrono::steady_clock Clock;
+    Measure result = { 0, 0.0, 0 };
+    const std::size_t allocationsBefore = allocations();
+    const Clock::time_point begin = Clock::now();
+    do {
+        f();
+        ++result.iterations;
+        result.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    } while (result.seconds < minSeconds);
+    result.allocations = allocations() - allocationsBefore;
+    return result;
+}
+
+/// Prints a result line (ns/op, MB/s and allocations/op) and records it
+/// for the JSON results (see mustache-bench --json).
+///
+/// @param name
+///     Name of the measure.
+/// @param measure
+///     The measure.
+/// @param bytes
+///     Bytes processed by each iteration (0 if not relevant).
+/// @param notes
+///     Free text appended to the line.
+///
+void report(const std::string& name, const Measure& measure,
+            std::size_t bytes = 0, const std::string& notes = "");
+
+} // namespace bench
+
+////////////////////////////////////////////////////////////////////////////////
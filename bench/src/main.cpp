@@ -0,0 +1,250 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       main.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache benchmarks (main file).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "bench.hpp"
+
+#include <string>
+using std::string;
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+// Every allocation of the program (library included) goes through these,
+// so benchmarks can report allocations per operation.
+static std::atomic<std::size_t> allocationCount(0);
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+namespace bench {
+
+typedef std::vector<std::pair<string, Function> > Benchmarks;
+
+static Benchmarks& benchmarks() {
+    static Benchmarks all;
+    return all;
+}
+
+/// Name of the running benchmark.
+static string currentBenchmark;
+
+/// Results of all the measures (see report()).
+static json& results() {
+    static json all = json::array();
+    return all;
+}
+
+Registrar::Registrar(const char* name, Function function) {
+    benchmarks().push_back(std::make_pair(string(name), function));
+}
+
+std::size_t allocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+const string& fixturesPath() {
+    static const string path = "./test/fixtures/";
+    return path;
+}
+
+const std::vector<Scale>& scales() {
+    static const std::vector<Scale> all = {
+        { "small", 1 },
+        { "medium", 100 },
+        { "huge", 5000 }
+    };
+    return all;
+}
+
+json scaleContext(const json& context, std::size_t factor) {
+    if (context.is_object()) {
+        json scaled = json::object();
+        for (json::const_iterator it = context.begin(); it != context.end(); ++it) {
+            scaled[it.key()] = scaleContext(it.value(), factor);
+        }
+        return scaled;
+    }
+    if (context.is_array()) {
+        json scaled = json::array();
+        for (std::size_t i = 0; i < factor; ++i) {
+            for (const json& item : context) {
+                scaled.push_back(scaleContext(item, factor));
+            }
+        }
+        return scaled;
+    }
+    return context;
+}
+
+string scaleText(const string& text, std::size_t factor) {
+    string scaled;
+    scaled.reserve(text.size() * factor);
+    for (std::size_t i = 0; i < factor; ++i) {
+        scaled += text;
+    }
+    return scaled;
+}
+
+void report(const string& name, const Measure& measure, std::size_t bytes,
+            const string& notes) {
+    const double nsPerOp = measure.seconds * 1e9 / measure.iterations;
+    const double allocationsPerOp = static_cast<double>(measure.allocations) / measure.iterations;
+    json result = {
+        { "benchmark", currentBenchmark },
+        { "name", name },
+        { "iterations", measure.iterations },
+        { "ns_per_op", nsPerOp },
+        { "allocations_per_op", allocationsPerOp }
+    };
+
+    std::cout << std::left << std::setw(48) << name << std::right
+              << std::setw(12) << std::fixed << std::setprecision(0) << nsPerOp << " ns/op";
+    if (bytes > 0) {
+        const double mbPerSecond = bytes * measure.iterations / measure.seconds / 1e6;
+        std::cout << std::setw(10) << std::setprecision(1) << mbPerSecond << " MB/s";
+        result["mb_per_s"] = mbPerSecond;
+    }
+    std::cout << std::setw(10) << std::setprecision(1) << allocationsPerOp << " allocs/op";
+    if (!notes.empty()) {
+        std::cout << "  " << notes;
+        result["notes"] = notes;
+    }
+    std::cout << std::endl;
+    results().push_back(result);
+}
+
+/// Prints the change of every measure against the same measure in a
+/// previous JSON results file.
+static int compare(const string& fileName) {
+    std::ifstream file(fileName);
+    if (!file) {
+        std::cerr << "Cannot open " << fileName << std::endl;
+        return 1;
+    }
+    json previous;
+    try {
+        file >> previous;
+    } catch (const json::exception& e) {
+        std::cerr << fileName << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "== compare with " << fileName << std::endl;
+    for (const json& result : results()) {
+        for (const json& old : previous["results"]) {
+            if (old.value("name", "") != result["name"].get<string>()) {
+                continue;
+            }
+            const double before = old.value("ns_per_op", 0.0);
+            const double after = result["ns_per_op"].get<double>();
+            std::cout << std::left << std::setw(48) << result["name"].get<string>()
+                      << std::right << std::setw(12) << std::fixed << std::setprecision(0)
+                      << before << " -> " << after << " ns/op";
+            if (before > 0.0) {
+                std::cout << std::showpos << std::setw(9) << std::setprecision(1)
+                          << (after - before) * 100.0 / before << "%" << std::noshowpos;
+            }
+            std::cout << std::setw(10) << std::setprecision(1)
+                      << old.value("allocations_per_op", 0.0) << " -> "
+                      << result["allocations_per_op"].get<double>() << " allocs/op" << std::endl;
+            break;
+        }
+    }
+    return 0;
+}
+
+} // namespace bench
+
+// Usage: mustache-bench [--json results.json] [--compare previous.json] [filter]
+// Runs the benchmarks whose name contains filter (all if missing).
+// --json writes all the measures to a file, --compare prints the changes
+// against a file written by a previous run (Eg: of another version).
+int main(int argc, char* argv[]) {
+    string filter;
+    string jsonFileName;
+    string compareFileName;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonFileName = argv[++i];
+        } else if (std::strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            compareFileName = argv[++i];
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    const bench::Benchmarks& all = bench::benchmarks();
+    for (bench::Benchmarks::size_type i = 0; i < all.size(); ++i) {
+        if (all.at(i).first.find(filter) != string::npos) {
+            std::cout << "== " << all.at(i).first << std::endl;
+            bench::currentBenchmark = all.at(i).first;
+            all.at(i).second();
+        }
+    }
+
+    if (!jsonFileName.empty()) {
+        std::ofstream file(jsonFileName);
+        file << json({ { "results", bench::results() } }).dump(2) << std::endl;
+        if (!file) {
+            std::cerr << "Cannot write " << jsonFileName << std::endl;
+            return 1;
+        }
+    }
+    if (!compareFileName.empty()) {
+        return bench::compare(compareFileName);
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,295 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-batch.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Renders a template with each context of an NDJSON stream
+///             (or builds a static site incrementally).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./src/mustache-light.hpp"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+using std::cerr;
+using std::endl;
+using std::string;
+using std::vector;
+
+using namespace mustache;
+// for convenience
+using json = nlohmann::json;
+
+// -----------------------------------------------------------------------------
+
+static void usage() {
+    cerr << "Usage: mustache-batch [options] view [contexts.ndjson]" << endl
+            << "       mustache-batch [options] -s state.json [pages.ndjson]" << endl
+            << "Renders view (a file name relative to base path, without extension)" << endl
+            << "with each line of contexts (standard input if missing)." << endl
+            << "With -s builds a static site: each line of pages is a page" << endl
+            << "{\"output\": path, \"view\": name, \"context\": name} and only the" << endl
+            << "pages whose inputs changed since the last build are rendered." << endl
+            << "Options:" << endl
+            << "  -b path     Base path (default ./)" << endl
+            << "  -t threads  Worker threads (default: one per hardware thread)" << endl
+            << "  -c records  Records rendered at once (default 1024)" << endl
+            << "  -d text     Delimiter written after each output (default \\n;" << endl
+            << "              \\n, \\t and \\0 are replaced)" << endl
+            << "  -o pattern  Writes each output to a file: %n in pattern is" << endl
+            << "              replaced with the line number (Eg: out/page-%n.html)" << endl
+            << "  -s state    Site build: dependencies of the last build" << endl;
+}
+
+// Builds the pages listed in in (see SiteBuilder).
+static int buildSite(const Engine& engine, const string& statePath, std::istream& in, unsigned threads) {
+    vector<SitePage> pages;
+    string line;
+    for (std::size_t lineNumber = 1; std::getline(in, line); ++lineNumber) {
+        if (line.find_first_not_of(" \t\r") == string::npos) {
+            continue;
+        }
+        try {
+            const json page = json::parse(line);
+            pages.push_back({ page.at("output").get<string>(), page.at("view").get<string>(),
+                              page.at("context").get<string>() });
+        } catch (const std::exception& e) {
+            cerr << "Line " << lineNumber << ": " << e.what() << endl;
+            return 1;
+        }
+    }
+
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    SiteBuildResult result;
+    try {
+        result = SiteBuilder(engine, statePath).build(pages, threads);
+    } catch (const RenderException& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    for (const std::pair<string, string>& error : result.errors) {
+        cerr << error.first << ": " << error.second << endl;
+    }
+    cerr << result.rendered << " pages rendered, " << result.skipped << " up to date, "
+            << result.errors.size() << " errors in "
+            << std::chrono::duration<double>(end - begin).count() << " s" << endl;
+
+    return result.errors.empty() ? 0 : 1;
+}
+
+// Replaces \n, \t and \0 with the characters they stand for.
+static string unescape(const string& text) {
+    string result;
+    for (string::size_type i = 0; i < text.size(); ++i) {
+        if (text[i] == '\\' && i + 1 < text.size()) {
+            switch (text[i + 1]) {
+            case 'n': result.push_back('\n'); ++i; continue;
+            case 't': result.push_back('\t'); ++i; continue;
+            case '0': result.push_back('\0'); ++i; continue;
+            default: break;
+            }
+        }
+        result.push_back(text[i]);
+    }
+    return result;
+}
+
+// Replaces %n in pattern with a line number.
+static string outputFileName(const string& pattern, std::size_t line) {
+    string result = pattern;
+    const string number = std::to_string(line);
+    for (string::size_type found = result.find("%n"); found != string::npos;
+         found = result.find("%n", found + number.size())) {
+        result.replace(found, 2, number);
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    string basePath = "./";
+    unsigned threads = 0;
+    std::size_t chunkSize = 1024;
+    string delimiter = "\n";
+    string pattern;
+    string statePath;
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-' && argv[arg][1] != '\0'; arg += 2) {
+        const string option = argv[arg];
+        if (arg + 1 == argc) {
+            usage();
+            return 2;
+        }
+        const string value = argv[arg + 1];
+        if (option == "-b") {
+            basePath = value;
+        } else if (option == "-t") {
+            threads = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (option == "-c") {
+            chunkSize = std::strtoul(value.c_str(), nullptr, 10);
+        } else if (option == "-d") {
+            delimiter = unescape(value);
+        } else if (option == "-o") {
+            pattern = value;
+        } else if (option == "-s") {
+            statePath = value;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    const bool site = !statePath.empty();
+    if ((!site && arg == argc) || argc - arg > (site ? 1 : 2) || chunkSize == 0) {
+        usage();
+        return 2;
+    }
+
+    const Engine engine(basePath);
+    TemplatePtr view;
+    if (!site) {
+        try {
+            view = engine.load(argv[arg]);
+        } catch (const RenderException& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+        ++arg;
+    }
+
+    std::ifstream file;
+    if (arg < argc && string(argv[arg]) != "-") {
+        file.open(argv[arg], std::ios::in | std::ios::binary);
+        if (!file) {
+            cerr << "Cannot open file: " << argv[arg] << endl;
+            return 1;
+        }
+    }
+    std::istream& in = file.is_open() ? static_cast<std::istream&>(file) : std::cin;
+    std::ios::sync_with_stdio(false);
+
+    if (site) {
+        return buildSite(engine, statePath, in, threads);
+    }
+
+    ThreadPool pool(threads);
+    BatchRenderer batch(engine, pool);
+
+    // Only a chunk of records is in memory at once: buffers are reused
+    vector<string> lines(chunkSize);
+    vector<std::size_t> lineNumbers(chunkSize);
+    vector<json> contexts;
+    vector<string> parseErrors(chunkSize);
+    vector<string> outputs;
+
+    std::size_t lineNumber = 0;
+    std::size_t records = 0;
+    std::size_t errors = 0;
+    std::size_t bytes = 0;
+
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    while (in) {
+        std::size_t count = 0;
+        while (count < chunkSize && std::getline(in, lines[count])) {
+            ++lineNumber;
+            if (lines[count].find_first_not_of(" \t\r") != string::npos) {
+                lineNumbers[count] = lineNumber;
+                ++count;
+            }
+        }
+        if (count == 0) {
+            break;
+        }
+
+        // Parsing takes as long as rendering: it runs on the pool too
+        contexts.resize(count);
+        {
+            TaskGroup group(pool);
+            for (std::size_t i = 0; i < count; ++i) {
+                group.run([&lines, &contexts, &parseErrors, i]() {
+                    parseErrors[i].clear();
+                    try {
+                        contexts[i] = json::parse(lines[i]);
+                    } catch (const std::exception& e) {
+                        contexts[i] = nullptr;
+                        parseErrors[i] = e.what();
+                    }
+                });
+            }
+            group.wait();
+        }
+
+        const vector<string> renderErrors = batch.render(*view, contexts, outputs);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            const string& error = !parseErrors[i].empty() ? parseErrors[i] : renderErrors[i];
+            if (!error.empty()) {
+                cerr << "Line " << lineNumbers[i] << ": " << error << endl;
+                ++errors;
+                // Keep outputs aligned with records
+                outputs[i].clear();
+            }
+            if (pattern.empty()) {
+                std::cout.write(outputs[i].data(), outputs[i].size());
+                std::cout.write(delimiter.data(), delimiter.size());
+            } else if (error.empty()) {
+                const string fileName = outputFileName(pattern, lineNumbers[i]);
+                std::ofstream out(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+                if (!out.write(outputs[i].data(), outputs[i].size())) {
+                    cerr << "Cannot write file: " << fileName << endl;
+                    ++errors;
+                }
+            }
+            bytes += outputs[i].size();
+        }
+        records += count;
+    }
+    std::cout.flush();
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - begin).count();
+    cerr << records << " records, " << errors << " errors, " << bytes << " bytes in "
+            << seconds << " s";
+    if (seconds > 0) {
+        cerr << " (" << static_cast<std::size_t>(records / seconds) << " records/s, "
+                << bytes / seconds / (1024 * 1024) << " MiB/s)";
+    }
+    cerr << endl;
+
+    return errors == 0 ? 0 : 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -36,6 +36,7 @@
 #include "./src/mustache-light.hpp"
 
 #include <string>
+#include <vector>
 #include <fstream>
 #include <iostream>
 #include <chrono>
@@ -50,7 +51,70 @@ using json = nlohmann::json;
 
 // -----------------------------------------------------------------------------
 
+// Compiles all the templates in basePath, printing compile times and errors.
+static int warmUp(const string& basePath) {
+    const Engine engine(basePath);
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    const std::vector<WarmUpResult> results = engine.warmUp();
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    std::size_t errors = 0;
+    for (const WarmUpResult& result : results) {
+        cout << result.elapsed.count() << " us\t" << result.fileName;
+        if (!result.error.empty()) {
+            cout << "\tError: " << result.error;
+            ++errors;
+        }
+        cout << endl;
+    }
+    cout << "------------------------------------------------------" << endl
+            << results.size() << " templates, " << errors << " errors" << endl
+            << "Elapsed = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << " us" << endl;
+
+    return errors == 0 ? 0 : 1;
+}
+
+// Renders a fixture many times with profiling enabled, then prints the
+// slowest tags and writes the folded stacks of partials (if foldedFile is
+// given).
+static int profile(const string& view, const string& context, std::size_t renders,
+                   const string& foldedFile) {
+    Mustache m("./test/fixtures/");
+    const TemplatePtr compiled = m.engine().load(view);
+    const json data = json::parse(m.fileRead(context, "json"));
+    Renderer renderer(m.engine());
+    Profile profile;
+    renderer.setProfile(&profile, view);
+
+    for (std::size_t i = 0; i < renders; ++i) {
+        if (!renderer.render(*compiled, data)) {
+            std::cerr << "Error: " << renderer.error() << endl;
+            return 1;
+        }
+    }
+    cout << profile.report();
+
+    if (!foldedFile.empty()) {
+        std::ofstream file(foldedFile);
+        file << profile.foldedStacks();
+        if (!file) {
+            std::cerr << "Cannot write file: " << foldedFile << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
+    if (argc >= 2 && string(argv[1]) == "--warm-up") {
+        return warmUp(argc >= 3 ? argv[2] : "./test/fixtures/");
+    }
+    if (argc >= 4 && string(argv[1]) == "--profile") {
+        return profile(argv[2], argv[3], argc >= 5 ? std::stoul(argv[4]) : 1000,
+                       argc >= 6 ? argv[5] : "");
+    }
+
     string view = "basic/empty";
     string context = "basic/empty";
 
@@ -62,7 +126,9 @@ int main(int argc, char *argv[]) {
         view = argv[1];
         context = argv[2];
     } else {
-        std::cerr << "Usage: test-mustache view context" << endl;
+        std::cerr << "Usage: test-mustache view context" << endl
+                << "       test-mustache --warm-up [base-path]" << endl
+                << "       test-mustache --profile view context [renders] [folded-stacks-file]" << endl;
     }
 
     cout << "Open view: " << view << endl;
@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-allocation.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Allocation accounting.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-allocation.hpp"
+
+#include <atomic>
+
+namespace mustache {
+
+// Trivial types: usable by operator new before and after any constructor
+static thread_local Allocations allocations = { 0, 0 };
+static std::atomic<bool> counted(false);
+
+Allocations& threadAllocations() {
+    return allocations;
+}
+
+bool allocationsCounted() {
+    return counted.load(std::memory_order_relaxed);
+}
+
+void countAllocation(std::size_t size) {
+    ++allocations.count;
+    allocations.bytes += size;
+    if (!counted.load(std::memory_order_relaxed)) {
+        counted.store(true, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
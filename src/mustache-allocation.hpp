@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-allocation.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Allocation accounting.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace mustache {
+
+/// Heap allocations made by a thread.
+struct Allocations {
+    /// Calls to operator new
+    std::size_t count;
+
+    /// Bytes requested (frees are not subtracted)
+    std::size_t bytes;
+};
+
+/// Allocations of the calling thread so far.
+///
+/// They are counted only if the program installs the counting operators
+/// (see MUSTACHE_COUNT_ALLOCATIONS()), otherwise they stay zero.
+///
+Allocations& threadAllocations();
+
+/// True if the program installed the counting operators.
+bool allocationsCounted();
+
+/// Called by the counting operators: adds an allocation of size bytes to
+/// the calling thread.
+void countAllocation(std::size_t size);
+
+} // namespace mustache
+
+/// Replaces the global operator new and delete with versions that count
+/// the allocations of each thread (see mustache::threadAllocations()).
+/// Renderers then report their allocations in RenderStats.
+///
+/// A library must not replace the operators of its host program, so it is
+/// up to the program: use it once, outside any namespace, in one of its
+/// source files.
+///
+#define MUSTACHE_COUNT_ALLOCATIONS()                                        \
+    void* operator new(std::size_t size) {                                  \
+        mustache::countAllocation(size);                                    \
+        void* pointer = std::malloc(size == 0 ? 1 : size);                  \
+        if (pointer == nullptr) {                                           \
+            throw std::bad_alloc();                                         \
+        }                                                                   \
+        return pointer;                                                     \
+    }                                                                       \
+    void operator delete(void* pointer) noexcept {                          \
+        std::free(pointer);                                                 \
+    }
+
+////////////////////////////////////////////////////////////////////////////////
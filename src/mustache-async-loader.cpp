@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-async-loader.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Asynchronous template loaders.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-async-loader.hpp"
+#include "./mustache-engine.hpp"
+#include "./mustache-exception.hpp"
+#include "./mustache-thread-pool.hpp"
+
+#include <string>
+using std::string;
+
+namespace mustache {
+
+AsyncLoader::~AsyncLoader() {
+}
+
+ThreadPoolLoader::ThreadPoolLoader(const Engine& engine, ThreadPool& pool) :
+        engine_(engine), pool_(pool) {
+}
+
+void ThreadPoolLoader::read(const string& fileName, Callback done) {
+    const Engine& engine = engine_;
+    pool_.submit([&engine, fileName, done]() {
+        string contents;
+        string error;
+        try {
+            contents = engine.fileRead(fileName);
+        } catch (const RenderException& err) {
+            error = err.what();
+        }
+        done(contents, error);
+    });
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
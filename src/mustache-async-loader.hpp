@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-async-loader.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Asynchronous template loaders.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <functional>
+
+namespace mustache {
+
+class Engine;
+class ThreadPool;
+
+/// Reads template files without blocking the rendering thread.
+///
+/// Used by Renderer::renderAsync(): when a partial is not cached the
+/// renderer asks the loader to read it and goes on when the data arrives.
+/// Implement it on top of the I/O of your event loop.
+///
+class AsyncLoader {
+  public:
+    // Public part
+
+    /// Called when a read completes, from any thread.
+    ///
+    /// @param contents
+    ///     The file contents.
+    /// @param error
+    ///     The error message (empty if the read succeeded). It's used as
+    ///     render error if the partial is needed.
+    ///
+    typedef std::function<void(const std::string& contents,
+                               const std::string& error)> Callback;
+
+    virtual ~AsyncLoader();
+
+    /// Starts reading a template file.
+    ///
+    /// @param fileName
+    ///     File name relative to base path, without extension (as given to
+    ///     Engine::load()).
+    /// @param done
+    ///     Called once when the read completes (it may be called before
+    ///     read() returns).
+    ///
+    virtual void read(const std::string& fileName, Callback done) = 0;
+};
+
+/// Reads template files with Engine::fileRead() on a thread pool.
+class ThreadPoolLoader : public AsyncLoader {
+  public:
+    // Public part
+
+    /// Construct a loader.
+    ///
+    /// @param engine
+    ///     The engine giving base path and extension. It must outlive the
+    ///     loader.
+    /// @param pool
+    ///     Threads doing the reads. It must outlive the loader.
+    ///
+    ThreadPoolLoader(const Engine& engine, ThreadPool& pool);
+
+    void read(const std::string& fileName, Callback done) override;
+
+  private:
+    // Private part
+
+    const Engine& engine_;
+    ThreadPool& pool_;
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-batch-renderer.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Parallel renders of one template with reusable renderers.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-batch-renderer.hpp"
+#include "./mustache-engine.hpp"
+#include "./mustache-renderer.hpp"
+#include "./mustache-thread-pool.hpp"
+
+#include <vector>
+using std::vector;
+#include <memory>
+using std::unique_ptr;
+#include <string>
+using std::string;
+
+#include <algorithm>
+
+namespace mustache {
+
+BatchRenderer::BatchRenderer(const Engine& engine, ThreadPool& pool) :
+        engine_(engine), pool_(pool), renderers_(pool.size() + 1),
+        busy_(pool.size() + 1, 0), caller_(std::this_thread::get_id()) {
+}
+
+BatchRenderer::~BatchRenderer() {
+}
+
+vector<string> BatchRenderer::render(const Template& view,
+                                     const vector<nlohmann::json>& contexts,
+                                     vector<string>& outputs) {
+    const std::size_t count = contexts.size();
+    vector<string> errors(count);
+    outputs.resize(count);
+    caller_ = std::this_thread::get_id();
+
+    // Small chunks keep all workers busy until the end, big chunks
+    // reduce scheduling overhead.
+    const std::size_t chunks = static_cast<std::size_t>(pool_.size()) * 8;
+    const std::size_t chunkSize = count / chunks + 1;
+
+    TaskGroup group(pool_);
+    for (std::size_t begin = 0; begin < count; begin += chunkSize) {
+        const std::size_t end = std::min(count, begin + chunkSize);
+        group.run([this, &view, &contexts, &outputs, &errors, begin, end]() {
+            const Lease lease(*this);
+            Renderer& renderer = lease.renderer();
+            for (std::size_t i = begin; i < end; ++i) {
+                renderer.render(view, contexts[i]);
+                outputs[i].assign(renderer.output());
+                errors[i].assign(renderer.error());
+            }
+        });
+    }
+    group.wait();
+
+    return errors;
+}
+
+std::size_t BatchRenderer::renderers() const {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < renderers_.size(); ++i) {
+        if (renderers_[i]) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+std::size_t BatchRenderer::slot() const {
+    const unsigned index = pool_.workerIndex();
+    if (index == pool_.size() && std::this_thread::get_id() != caller_) {
+        // Threads waiting for other groups run tasks too
+        return renderers_.size();
+    }
+    return index;
+}
+
+BatchRenderer::Lease::Lease(BatchRenderer& batch) :
+        batch_(batch), slot_(batch.slot()), renderer_(nullptr) {
+    if (slot_ < batch_.renderers_.size() && batch_.busy_[slot_]) {
+        // A render of this thread is waiting for the pool
+        slot_ = batch_.renderers_.size();
+    }
+    if (slot_ == batch_.renderers_.size()) {
+        local_.reset(new Renderer(batch_.engine_));
+        renderer_ = local_.get();
+        return;
+    }
+    unique_ptr<Renderer>& kept = batch_.renderers_[slot_];
+    if (!kept) {
+        kept.reset(new Renderer(batch_.engine_));
+    }
+    batch_.busy_[slot_] = 1;
+    renderer_ = kept.get();
+}
+
+BatchRenderer::Lease::~Lease() {
+    if (slot_ < batch_.renderers_.size()) {
+        batch_.busy_[slot_] = 0;
+    }
+}
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,160 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-batch-renderer.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Parallel renders of one template with reusable renderers.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <cstddef>
+
+#include "json.hpp"
+#include "mustache-template.hpp"
+
+namespace mustache {
+
+class Engine;
+class Renderer;
+class ThreadPool;
+
+/// Renders batches of contexts on a ThreadPool, keeping one Renderer for
+/// each worker (and one for the calling thread) across batches.
+///
+/// Renderers keep their output buffers and stacks, so a caller rendering
+/// a stream in chunks allocates them once instead of once per chunk.
+/// A BatchRenderer is used by one thread at a time; the engine and the
+/// pool must outlive it.
+///
+class BatchRenderer {
+  public:
+    // Public part
+
+    /// Construct a batch renderer. Renderers are created on first use.
+    /// The calling thread owns the renderer kept for non-worker threads
+    /// (until it calls render()).
+    BatchRenderer(const Engine& engine, ThreadPool& pool);
+
+    ~BatchRenderer();
+
+    /// Renders a template with many contexts in parallel.
+    ///
+    /// @param view
+    ///     The compiled template.
+    /// @param contexts
+    ///     The contexts: one render for each context.
+    /// @param outputs
+    ///     Filled with the output of each render (same order of contexts).
+    ///     Existing strings are reused.
+    ///
+    /// @return
+    ///     The error of each render (empty if the render succeeded).
+    ///
+    std::vector<std::string> render(const Template& view,
+                                    const std::vector<nlohmann::json>& contexts,
+                                    std::vector<std::string>& outputs);
+
+    /// Number of renderers kept (at most the pool size plus one).
+    std::size_t renderers() const;
+
+    /// A renderer for the calling thread, taken for the lifetime of the
+    /// lease: the one kept for the thread if it's free, otherwise a new
+    /// one. A render waiting for its partials or sections on the pool
+    /// runs other tasks meanwhile, so its renderer is still busy.
+    ///
+    /// Tasks of the pool that render many items (Eg: render(), or
+    /// SiteBuilder) take one lease for each task.
+    ///
+    class Lease {
+      public:
+        // Public part
+
+        explicit Lease(BatchRenderer& batch);
+
+        ~Lease();
+
+        Renderer& renderer() const {
+            return *renderer_;
+        }
+
+      private:
+        // Private part
+
+        BatchRenderer& batch_;
+
+        /// Index in renderers_ (renderers_.size() for a local renderer)
+        std::size_t slot_;
+
+        /// Renderer used when no kept renderer is free
+        std::unique_ptr<Renderer> local_;
+
+        Renderer* renderer_;
+
+        // Disallow copy constructor and assign operator
+        Lease(const Lease&);
+        void operator=(const Lease&);
+    };
+
+  private:
+    // Private part
+
+    const Engine& engine_;
+    ThreadPool& pool_;
+
+    /// One renderer for each worker, the last one for the thread that
+    /// created the batch renderer or called render(): each one is used by
+    /// its thread only
+    std::vector<std::unique_ptr<Renderer> > renderers_;
+
+    /// Renderers of renderers_ leased (not bool: each thread writes its
+    /// own element)
+    std::vector<unsigned char> busy_;
+
+    /// Thread owning the last renderer
+    std::thread::id caller_;
+
+    /// Index in renderers_ of the renderer of the calling thread, or
+    /// renderers_.size() for threads of other groups that run a task while
+    /// waiting.
+    std::size_t slot() const;
+
+    // Disallow copy constructor and assign operator
+    BatchRenderer(const BatchRenderer&);
+    void operator=(const BatchRenderer&);
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
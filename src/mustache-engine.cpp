@@ -0,0 +1,448 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-engine.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Thread-safe template engine (configuration and caches).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-engine.hpp"
+#include "./mustache-batch-renderer.hpp"
+#include "./mustache-exception.hpp"
+#include "./mustache-internal.hpp"
+#include "./mustache-renderer.hpp"
+#include "./mustache-stats.hpp"
+#include "./mustache-thread-pool.hpp"
+
+#include <map>
+using std::map;
+#include <vector>
+using std::vector;
+#include <string>
+using std::string;
+
+namespace mustache {
+
+EngineOptions::EngineOptions() :
+        partialExtension("mustache"), escape(Escape::Html),
+        threads(0), parallelSectionThreshold(0), parallelPartials(false), mapFiles(false) {
+}
+
+Engine::Engine(const string& basePath) :
+        basePath_(basePath), options_(),
+        partialExtension_(options_.partialExtension),
+        escape_(mustache::escapeFunction(options_.escape)),
+        source_(std::make_shared<DirectorySource>(basePath)) {
+}
+
+Engine::Engine(const string& basePath, const EngineOptions& options) :
+        basePath_(basePath), options_(options),
+        partialExtension_(options_.partialExtension),
+        escape_(mustache::escapeFunction(options_.escape)),
+        source_(options_.source ? options_.source
+                : std::make_shared<DirectorySource>(basePath, options_.mapFiles)) {
+    if (options_.parallelSectionThreshold > 0 || options_.parallelPartials) {
+        pool_.reset(new ThreadPool(options_.threads));
+    }
+}
+
+Engine::~Engine() {
+}
+
+const EngineOptions& Engine::options() const {
+    return options_;
+}
+
+ThreadPool* Engine::pool() const {
+    return pool_.get();
+}
+
+const string& Engine::basePath() const {
+    return basePath_;
+}
+
+const string& Engine::partialExtension() const {
+    return partialExtension_;
+}
+
+EscapeFunction Engine::escapeFunction() const {
+    return escape_;
+}
+
+TemplatePtr Engine::compile(const string& view) const {
+    return std::make_shared<const Template>(view);
+}
+
+TemplatePtr Engine::load(const string& fileName) const {
+    return load(fileName, nullptr);
+}
+
+TemplatePtr Engine::load(const string& fileName, RenderStats* stats) const {
+    TemplatePtr compiled = cache_.find(fileName);
+    if (!compiled && options_.store && (compiled = options_.store->find(fileName))) {
+        compiled = cache_.insert(fileName, compiled);
+    }
+    if (compiled) {
+        if (stats != nullptr) {
+            ++stats->partialHits;
+        }
+        return compiled;
+    }
+    // Read and compile before publishing: other threads keep rendering
+    return cache_.insert(fileName, compileFile(fileName, stats));
+}
+
+// Parameters are part of the tag, so the substituted template can be
+// cached too: the key is the whole tag.
+static void partialKey(string& key, const string& fileName, const vector<string>& parameters) {
+    key.assign(fileName);
+    for (vector<string>::size_type i = 0; i < parameters.size(); ++i) {
+        key.push_back('|');
+        key.append(parameters.at(i));
+    }
+}
+
+TemplatePtr Engine::loadPartial(const string& fileName,
+                                const vector<string>& parameters,
+                                RenderStats* stats) const {
+    if (parameters.empty()) {
+        return load(fileName, stats);
+    }
+
+    // Cache hits do not allocate: the key is built in a buffer of the thread
+    static thread_local string buffer;
+    partialKey(buffer, fileName, parameters);
+    TemplatePtr compiled = cache_.find(buffer);
+    if (compiled) {
+        if (stats != nullptr) {
+            ++stats->partialHits;
+        }
+        return compiled;
+    }
+    const string key = buffer;
+    const TemplatePtr file = load(fileName, stats);
+    if (stats == nullptr) {
+        return cache_.insert(key, partialSubstitute(*file, parameters));
+    }
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    compiled = partialSubstitute(*file, parameters);
+    stats->tokenizeTime += std::chrono::steady_clock::now() - begin;
+    return cache_.insert(key, compiled);
+}
+
+TemplatePtr Engine::find(const string& fileName,
+                         const vector<string>& parameters) const {
+    string key;
+    if (!parameters.empty()) {
+        partialKey(key, fileName, parameters);
+        const TemplatePtr compiled = cache_.find(key);
+        if (compiled) {
+            return compiled;
+        }
+    }
+
+    TemplatePtr file = cache_.find(fileName);
+    if (!file && options_.store && (file = options_.store->find(fileName))) {
+        file = cache_.insert(fileName, file);
+    }
+    if (parameters.empty() || !file) {
+        return file;
+    }
+    return cache_.insert(key, partialSubstitute(*file, parameters));
+}
+
+TemplatePtr Engine::add(const string& fileName, const string& contents) const {
+    return cache_.insert(fileName, compile(contents));
+}
+
+vector<string> Engine::renderBatch(const Template& view,
+                                   const vector<nlohmann::json>& contexts,
+                                   vector<string>& outputs,
+                                   unsigned threads) const {
+    ThreadPool pool(threads);
+    return renderBatch(view, contexts, outputs, pool);
+}
+
+vector<string> Engine::renderBatch(const Template& view,
+                                   const vector<nlohmann::json>& contexts,
+                                   vector<string>& outputs,
+                                   ThreadPool& pool) const {
+    BatchRenderer batch(*this, pool);
+    return batch.render(view, contexts, outputs);
+}
+
+/// A partial used by a template.
+struct PartialReference {
+    string fileName;
+    vector<string> parameters;
+};
+
+/// Checks the structure of a template (the same the renderer expects),
+/// collecting the partials it uses.
+///
+/// @return
+///     The first error found (empty if the template is valid).
+///
+static string checkTemplate(const Template& view, vector<PartialReference>& partials) {
+    vector<string> sections;
+    const std::size_t size = view.size();
+    std::size_t i = 0;
+    while (i < size) {
+        const TokenKind kind = view.kind(i);
+        if (kind == TokenKind::Text) {
+            ++i;
+            continue;
+        }
+        if (kind == TokenKind::End || kind == TokenKind::EndUnescaped) {
+            return "Unexpected end of variable '" + tokenKindText(kind) + "'";
+        }
+        if (i + 1 == size || i + 2 == size) {
+            return "Unexpected end of file.";
+        }
+        if (view.kind(i + 1) != TokenKind::Text) {
+            return "Unexpected " + tokenKindText(view.kind(i + 1));
+        }
+        const TokenKind end = (kind == TokenKind::StartVariableUnescaped)
+                ? TokenKind::EndUnescaped : TokenKind::End;
+        if (view.kind(i + 2) != end) {
+            return "Missing " + tokenKindText(end);
+        }
+
+        const string& tag = view.text(i + 1);
+        switch (kind) {
+        case TokenKind::StartBeginSection:
+        case TokenKind::StartIf:
+        case TokenKind::StartUnless:
+        case TokenKind::StartExistsTest:
+            sections.push_back(tag);
+            break;
+        case TokenKind::StartEndSection:
+            if (sections.empty()) {
+                return "Unexpected " + tokenKindText(kind) + " " + tag;
+            }
+            if (sections.back() != tag) {
+                return "Expected '" + sections.back() + "' in closing block (found '" + tag + "')";
+            }
+            sections.pop_back();
+            break;
+        case TokenKind::StartPartial: {
+            vector<string> splitted = split(tag, '|');
+            for (std::size_t p = 0; p < splitted.size(); ++p) {
+                trim(splitted.at(p));
+            }
+            if (splitted.empty() || splitted.at(0).empty()) {
+                return "Missing partial name";
+            }
+            PartialReference partial;
+            partial.fileName = splitted.at(0);
+            partial.parameters.assign(splitted.begin() + 1, splitted.end());
+            partials.push_back(partial);
+            break;
+        }
+        default:
+            break;
+        }
+        i += 3;
+    }
+    if (!sections.empty()) {
+        return "Missing " + tokenKindText(TokenKind::StartEndSection) + " " + sections.back();
+    }
+    return string();
+}
+
+vector<WarmUpResult> Engine::warmUp(unsigned threads) const {
+    ThreadPool pool(threads);
+    return warmUp(pool);
+}
+
+vector<WarmUpResult> Engine::warmUp(ThreadPool& pool) const {
+    const vector<string> fileNames = source_->list(partialExtension_);
+    vector<WarmUpResult> results(fileNames.size());
+    TaskGroup group(pool);
+    for (std::size_t i = 0; i < fileNames.size(); ++i) {
+        group.run([this, &fileNames, &results, i]() {
+            WarmUpResult& result = results[i];
+            result.fileName = fileNames[i];
+            const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            vector<PartialReference> partials;
+            try {
+                result.error = checkTemplate(*load(result.fileName), partials);
+            } catch (const RenderException& e) {
+                result.error = e.what();
+            }
+            result.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - begin);
+
+            // Partials not listed are loaded too (Eg: from the store)
+            for (std::size_t p = 0; p < partials.size() && result.error.empty(); ++p) {
+                try {
+                    loadPartial(partials[p].fileName, partials[p].parameters);
+                } catch (const RenderException& e) {
+                    result.error = string("Partial ") + partials[p].fileName + ": " + e.what();
+                }
+            }
+        });
+    }
+    group.wait();
+
+    return results;
+}
+
+TemplatePtr Engine::reload(const string& fileName) const {
+    const TemplatePtr compiled = compileFile(fileName);
+    cache_.replace(fileName, compiled);
+    cache_.erasePrefix(fileName + "|");
+    return compiled;
+}
+
+void Engine::evict(const string& fileName) const {
+    cache_.erase(fileName);
+    cache_.erasePrefix(fileName + "|");
+}
+
+void Engine::clearCache() const {
+    cache_.clear();
+}
+
+const TemplateSource& Engine::source() const {
+    return *source_;
+}
+
+string Engine::fileRead(const string& fileName, const string& fileExtension) const {
+        TemplateSource::Contents contents;
+        if (!source_->read(fileName, fileExtension, contents)) {
+                throw RenderException("Cannot open file: " + source_->describe(fileName, fileExtension));
+        }
+        return string(contents.data, contents.size);
+}
+
+string Engine::fileRead(const string& fileName) const {
+        return fileRead(fileName, partialExtension_);
+}
+
+TemplatePtr Engine::compileFile(const string& fileName, RenderStats* stats) const {
+    TemplateSource::Contents contents;
+    if (!source_->read(fileName, partialExtension_, contents)) {
+        throw RenderException("Cannot open file: " + source_->describe(fileName, partialExtension_));
+    }
+    if (stats == nullptr) {
+        return std::make_shared<const Template>(contents.data, contents.size, contents.storage);
+    }
+    ++stats->partialMisses;
+    stats->bytesRead += contents.size;
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    TemplatePtr compiled = std::make_shared<const Template>(contents.data, contents.size, contents.storage);
+    stats->tokenizeTime += std::chrono::steady_clock::now() - begin;
+    return compiled;
+}
+
+TemplatePtr Engine::partialSubstitute(const Template& partial,
+                                      const vector<string>& partialParams) const {
+        Variables partialVariables;
+        Template::Tokens newTokens = partial.tokens();
+
+        for (vector<string>::size_type i = 0; i != partialParams.size(); i++) {
+                const string& token = partialParams.at(i);
+                if (token.find_first_of("=") == string::npos) {
+                        throw RenderException("Bad substitution string: missing '=' in " + token);
+                }
+                vector<string> pair = split(token, '=');
+                if (pair.size() != 2) {
+                        throw RenderException("Bad substitution string: missing separator in " + token);
+                }
+
+                VariableConstIterator lb = partialSearchVariable(partialVariables, pair.at(1));
+
+                if (lb != partialVariables.end()) {
+                        // key already exists
+                        partialVariables.insert(lb, map<string, string>::value_type(pair.at(0), lb->second ));
+                } else {
+                        // the key does not exist in the map
+                        // add it to the map
+                        partialVariables.insert(lb, map<string, string>::value_type(pair.at(0), pair.at(1)));
+                        // Use lb as a hint to insert,
+                        // so it can avoid another lookup
+                }
+        }
+
+        for (Template::Tokens::size_type i = 1; i != newTokens.size(); i++) {
+                // Only (txt) can be substituted
+                if (newTokens.at(i).kind != TokenKind::Text) {
+                        continue;
+                }
+                const string& tokenToCheck = newTokens.at(i).text;
+                const TokenKind tokenToCheckPrev = newTokens.at(i - 1).kind;
+
+                // Searching
+                VariableIterator lb = partialVariables.find(tokenToCheck);
+                if (lb == partialVariables.end()) {
+                        continue;
+                }
+
+                // Substitution
+                string valueToSubstitute = lb->second;
+
+                if (valueToSubstitute[0] != '\'' && valueToSubstitute[0] != '\"') {
+                        // Simple substitution
+                } else {
+                        // Substitute literal
+
+                        if (tokenToCheckPrev != TokenKind::StartVariable) {
+                                continue;
+                        }
+
+                        if (valueToSubstitute[valueToSubstitute.size() - 1 ] != '\'' && valueToSubstitute[valueToSubstitute.size() - 1] != '\"') {
+                                throw RenderException("Substitution string " + valueToSubstitute + " not properly closed");
+                        }
+                        valueToSubstitute = valueToSubstitute.substr(1, valueToSubstitute.size() - 2);
+
+                        // "{{", "var", "}}" becomes a single (txt)
+                        i = i - 1;
+                        newTokens.erase(newTokens.begin() + i);
+                        newTokens.erase(newTokens.begin() + i);
+                        newTokens.at(i).kind = TokenKind::Text;
+                }
+                newTokens.at(i).text = valueToSubstitute;
+        }
+
+        return std::make_shared<const Template>(std::move(newTokens));
+}
+
+Engine::VariableConstIterator Engine::partialSearchVariable(const Engine::Variables& variables,
+        const string& valueToSearch) const {
+        if (valueToSearch[0] == '\'' || valueToSearch[0] == '\"') {
+                return variables.end();
+        }
+        return variables.find(valueToSearch);
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,382 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-engine.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Thread-safe template engine (configuration and caches).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <cstddef>
+
+#include "json.hpp"
+#include "mustache-escape.hpp"
+#include "mustache-template.hpp"
+#include "mustache-template-cache.hpp"
+#include "mustache-template-store.hpp"
+#include "mustache-source.hpp"
+#include "mustache-observer.hpp"
+
+namespace mustache {
+
+class ThreadPool;
+struct RenderStats;
+
+/// Options used to create an Engine.
+struct EngineOptions {
+    /// Initializes options with default values.
+    EngineOptions();
+
+    /// Default extension for partials ("mustache").
+    std::string partialExtension;
+
+    /// Escape policy used for escaped variables {{ var }} (Escape::Html).
+    Escape escape;
+
+    /// Worker threads used to parallelize a single render (0 means one per
+    /// hardware thread). Used only if a parallel feature is enabled.
+    unsigned threads;
+
+    /// Array sections {{# array }} with at least this number of items are
+    /// split into chunks rendered concurrently (0 disables the feature).
+    /// Output, @index and @first are the same of a sequential render.
+    std::size_t parallelSectionThreshold;
+
+    /// Renders visible partials {{> name }} concurrently (false by default).
+    /// Each partial is rendered into its own buffer while the including
+    /// template goes on; buffers are stitched in document order, so output
+    /// and errors are the same of a sequential render. Partials inside
+    /// array sections are rendered in place (see parallelSectionThreshold),
+    /// and sibling sections are not rendered concurrently.
+    bool parallelPartials;
+
+    /// Template files are mapped in memory instead of read (false by
+    /// default): text outside tags is not copied, the template points into
+    /// the file pages. Files must be replaced by renaming, not rewritten in
+    /// place, while they are mapped.
+    bool mapFiles;
+
+    /// Compiled templates shared with other processes (nullptr by default).
+    /// Templates found in the store are not read from files.
+    TemplateStorePtr store;
+
+    /// Where files are read from (nullptr by default: files in base path,
+    /// mapped if mapFiles is set). See DirectorySource, MemorySource and
+    /// EmbeddedSource.
+    TemplateSourcePtr source;
+
+    /// Receives the events of all the renders using the engine (nullptr
+    /// by default, see Renderer::setObserver()).
+    RenderObserverPtr observer;
+};
+
+/// Result of the warm up of a template file (see Engine::warmUp()).
+struct WarmUpResult {
+    /// File name relative to base path, without extension.
+    std::string fileName;
+
+    /// Time spent reading and compiling the file.
+    std::chrono::microseconds elapsed;
+
+    /// Empty if the file is valid, otherwise the first problem found (Eg:
+    /// a section not closed or a partial that cannot be loaded).
+    std::string error;
+};
+
+/// The template engine.
+///
+/// An Engine holds everything that does not change between renders:
+/// configuration and compiled templates (files and partials are read and
+/// compiled once, then cached).
+/// All the methods are thread-safe, so a single Engine can be shared by
+/// all the threads: each thread renders using its own Renderer.
+///
+class Engine {
+  public:
+    // Public part
+
+    /// Construct a new Engine, using basePath as base partial search path.
+    ///
+    /// @param basePath
+    ///     Base path for file searching. Must be an absolute path.
+    ///
+    explicit Engine(const std::string& basePath);
+
+    /// Construct a new Engine, using basePath as base partial search path.
+    ///
+    /// @param basePath
+    ///     Base path for file searching. Must be an absolute path.
+    /// @param options
+    ///     Engine options.
+    ///
+    Engine(const std::string& basePath, const EngineOptions& options);
+
+    ~Engine();
+
+    /// Options used to create the engine.
+    const EngineOptions& options() const;
+
+    /// Thread pool used to parallelize renders (nullptr if no parallel
+    /// feature is enabled).
+    ThreadPool* pool() const;
+
+    /// Base path for file searching.
+    const std::string& basePath() const;
+
+    /// Default extension for partials.
+    const std::string& partialExtension() const;
+
+    /// Escape function used for escaped variables {{ var }}.
+    EscapeFunction escapeFunction() const;
+
+    /// Compiles a view. The result is not cached.
+    ///
+    /// @param view
+    ///     The view with {{ ... }} tags.
+    ///
+    /// @return
+    ///     The compiled template.
+    ///
+    TemplatePtr compile(const std::string& view) const;
+
+    /// Loads and compiles a template file (with the partial extension).
+    /// The compiled template is cached. Templates in the store (see
+    /// EngineOptions) are taken from there.
+    ///
+    /// @param fileName
+    ///     File name relative to base path, without extension.
+    ///
+    /// @return
+    ///     The compiled template.
+    ///
+    /// @throws RenderException
+    ///     If the file cannot be opened.
+    ///
+    TemplatePtr load(const std::string& fileName) const;
+
+    /// Loads a partial and substitutes its parameters.
+    /// Eg: {{> user | Name='Mario' | Surname=surname }} has file name "user"
+    /// and parameters "Name='Mario'" and "Surname=surname".
+    /// The resulting template is cached.
+    ///
+    /// @param fileName
+    ///     File name relative to base path, without extension.
+    /// @param parameters
+    ///     Partial parameters (trimmed).
+    /// @param stats
+    ///     If not null cache hits and misses, bytes read and compile time
+    ///     are added to it.
+    ///
+    /// @return
+    ///     The compiled template.
+    ///
+    /// @throws RenderException
+    ///     If the file cannot be opened or parameters are malformed.
+    ///
+    TemplatePtr loadPartial(const std::string& fileName,
+                            const std::vector<std::string>& parameters,
+                            RenderStats* stats = nullptr) const;
+
+    /// Returns a cached (or stored) template file or partial without reading
+    /// files.
+    /// Partials with parameters are made from the cached file if needed.
+    ///
+    /// @param fileName
+    ///     File name relative to base path, without extension.
+    /// @param parameters
+    ///     Partial parameters (trimmed, see loadPartial()).
+    ///
+    /// @return
+    ///     The compiled template, or nullptr if the file is not cached.
+    ///
+    /// @throws RenderException
+    ///     If parameters are malformed.
+    ///
+    TemplatePtr find(const std::string& fileName,
+                     const std::vector<std::string>& parameters = std::vector<std::string>()) const;
+
+    /// Compiles the contents of a template file and caches it, as if it was
+    /// read by load(). Used by asynchronous loaders.
+    ///
+    /// @param fileName
+    ///     File name relative to base path, without extension.
+    /// @param contents
+    ///     The file contents.
+    ///
+    /// @return
+    ///     The compiled template (the one already cached, if any).
+    ///
+    TemplatePtr add(const std::string& fileName, const std::string& contents) const;
+
+    /// Compiles all the template files of the source (see
+    /// TemplateSource::list()) in parallel and caches them, so the first
+    /// renders do not read files.
+    /// Templates are checked too: tags must be well formed, sections closed
+    /// and partials {{> name }} must exist (partials with parameters are
+    /// compiled and cached as well). Dynamic templates {{< name }} are not
+    /// checked, their names come from contexts.
+    ///
+    /// @param threads
+    ///     Number of threads (0 means one per hardware thread).
+    ///
+    /// @return
+    ///     A result for each file, sorted by file name.
+    ///
+    std::vector<WarmUpResult> warmUp(unsigned threads = 0) const;
+
+    /// Warms up the cache using an existing pool. See warmUp() above.
+    std::vector<WarmUpResult> warmUp(ThreadPool& pool) const;
+
+    /// Renders a template with many contexts in parallel.
+    /// Each worker thread reuses its own Renderer.
+    ///
+    /// @param view
+    ///     The compiled template.
+    /// @param contexts
+    ///     The contexts: one render for each context.
+    /// @param outputs
+    ///     Filled with the output of each render (same order of contexts).
+    ///     Existing strings are reused.
+    /// @param threads
+    ///     Number of threads (0 means one per hardware thread).
+    ///
+    /// @return
+    ///     The error of each render (empty if the render succeeded).
+    ///
+    std::vector<std::string> renderBatch(const Template& view,
+                                         const std::vector<nlohmann::json>& contexts,
+                                         std::vector<std::string>& outputs,
+                                         unsigned threads = 0) const;
+
+    /// Renders a template with many contexts using an existing pool.
+    /// See renderBatch() above. Renderers last for this call only: use a
+    /// BatchRenderer to keep them across many batches.
+    std::vector<std::string> renderBatch(const Template& view,
+                                         const std::vector<nlohmann::json>& contexts,
+                                         std::vector<std::string>& outputs,
+                                         ThreadPool& pool) const;
+
+    /// Reads and compiles again a template file, replacing the cached one.
+    /// Partials with parameters made from it are removed from the cache.
+    /// Renders in progress keep using the templates they already hold.
+    ///
+    /// @param fileName
+    ///     File name relative to base path, without extension.
+    ///
+    /// @return
+    ///     The new compiled template.
+    ///
+    /// @throws RenderException
+    ///     If the file cannot be opened (the cache is left unchanged).
+    ///
+    TemplatePtr reload(const std::string& fileName) const;
+
+    /// Removes a template file from the cache, with the partials with
+    /// parameters made from it.
+    /// Renders in progress keep using the templates they already hold.
+    ///
+    /// @param fileName
+    ///     File name relative to base path, without extension.
+    ///
+    void evict(const std::string& fileName) const;
+
+    /// Removes all the compiled templates from the cache.
+    /// Renders in progress keep using the templates they already hold.
+    void clearCache() const;
+
+    /// The source files are read from.
+    const TemplateSource& source() const;
+
+    std::string fileRead(const std::string& fileName, const std::string& fileExtension) const;
+    std::string fileRead(const std::string& fileName) const;
+
+  private:
+    // Private part
+
+    typedef std::map<std::string, std::string> Variables;
+    typedef Variables::iterator VariableIterator;
+    typedef Variables::const_iterator VariableConstIterator;
+
+    /// Base path is added to file name each time a file must be opened.
+    const std::string basePath_;
+
+    const EngineOptions options_;
+
+    const std::string& partialExtension_;
+
+    /// Escapes variables printed with {{ var }}
+    const EscapeFunction escape_;
+
+    /// Files (options_.source or the base path directory)
+    const TemplateSourcePtr source_;
+
+    /// Workers for parallel renders
+    std::unique_ptr<ThreadPool> pool_;
+
+    /// Compiled templates by file name (and partial parameters, Eg:
+    /// "user|Name='Mario'"). Lookups are lock-free.
+    mutable TemplateCache cache_;
+
+    /// See load() and loadPartial()
+    TemplatePtr load(const std::string& fileName, RenderStats* stats) const;
+
+    /// Reads and compiles a template file.
+    TemplatePtr compileFile(const std::string& fileName, RenderStats* stats = nullptr) const;
+
+    /// Substitutes partial parameters inside a template.
+    TemplatePtr partialSubstitute(const Template& partial,
+                                  const std::vector<std::string>& parameters) const;
+
+    /// Searches a variable inside a Variable list.
+    ///
+    /// @param  variables     The variable list
+    /// @param  valueToSearch The key to search for
+    ///
+    /// @return               A VariableConstIterator pointer to pair found,
+    ///                       or variable_.end() if nothing is found.
+    ///
+    VariableConstIterator partialSearchVariable(const Variables& variables,
+        const std::string& valueToSearch) const;
+
+    // Disallow default constructor, copy constructor and assign operator
+    Engine();
+    Engine(const Engine&);
+    void operator=(const Engine&);
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
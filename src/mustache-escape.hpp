@@ -0,0 +1,251 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-escape.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Escape policies for escaped variables {{ var }}.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cctype>
+
+namespace mustache {
+
+/// Escape policy applied to escaped variables {{ var }}.
+/// Unescaped variables {{{ var }}} are always printed as they are.
+///
+enum class Escape {
+    Html,           ///< HTML text (default)
+    HtmlAttribute,  ///< HTML attribute values
+    Json,           ///< Content of a JSON string (quotes not added)
+    Csv,            ///< A CSV field (RFC 4180)
+    Url,            ///< URL component (percent encoding)
+    None            ///< No escape at all
+};
+
+/// Appends the escaped version of data to output.
+typedef void (*EscapeFunction)(std::string& output, const char* data, std::size_t size);
+
+/// Returns the escape function that implements an escape policy.
+///
+/// @param escape
+///     The escape policy.
+///
+/// @return
+///     A pointer to the escape function.
+///
+EscapeFunction escapeFunction(Escape escape);
+
+/// Appends data to output escaping it with Policy.
+///
+/// A Policy must provide two static functions:
+/// * <tt>bool isSafe(unsigned char ch)</tt>: true if ch is copied as it is;
+/// * <tt>void escape(std::string& output, unsigned char ch)</tt>: appends
+///   the escaped version of ch to output.
+///
+/// Runs of safe characters are appended in a single call.
+///
+template <class Policy>
+inline void escapeAppend(std::string& output, const char* data, std::size_t size) {
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        const unsigned char ch = static_cast<unsigned char>(data[i]);
+        if (!Policy::isSafe(ch)) {
+            output.append(data + start, i - start);
+            Policy::escape(output, ch);
+            start = i + 1;
+        }
+    }
+    output.append(data + start, size - start);
+}
+
+/// Escapes dangerous HTML characters with their named entities.
+/// Control characters are dropped. Bytes belonging to multi-byte UTF-8
+/// characters are copied as they are.
+///
+struct HtmlEscape {
+    static bool isSafe(unsigned char ch) {
+        if (ch >= 0x80) {
+            return true;
+        }
+        switch (ch) {
+        case '&': case '\"': case '\'': case '<': case '>': case '%':
+            return false;
+        default:
+            return !std::iscntrl(ch);
+        }
+    }
+
+    static void escape(std::string& output, unsigned char ch) {
+        switch (ch) {
+        case '&':   output.append("&amp;");     break;
+        case '\"':  output.append("&quot;");    break;
+        case '\'':  output.append("&apos;");    break;
+        case '<':   output.append("&lt;");      break;
+        case '>':   output.append("&gt;");      break;
+        case '%':   output.append("&percnt;");  break;
+        default:    /* Control char: dropped */ break;
+        }
+    }
+};
+
+/// Escapes every ASCII character that is not alphanumeric with an
+/// hexadecimal character reference (Eg: " " becomes "&#x20;"), so the value
+/// is safe even inside unquoted attributes.
+/// Control characters (but tabs and new lines) are dropped.
+///
+struct HtmlAttributeEscape {
+    static bool isSafe(unsigned char ch) {
+        return ch >= 0x80 || std::isalnum(ch);
+    }
+
+    static void escape(std::string& output, unsigned char ch) {
+        static const char hex[] = "0123456789ABCDEF";
+        if (std::iscntrl(ch) && ch != '\t' && ch != '\n' && ch != '\r') {
+            return;
+        }
+        output.append("&#x");
+        output.push_back(hex[ch >> 4]);
+        output.push_back(hex[ch & 0x0F]);
+        output.push_back(';');
+    }
+};
+
+/// Escapes a value to be placed inside a JSON string.
+/// Surrounding quotes are not added.
+///
+struct JsonEscape {
+    static bool isSafe(unsigned char ch) {
+        return ch >= 0x20 && ch != '\"' && ch != '\\';
+    }
+
+    static void escape(std::string& output, unsigned char ch) {
+        static const char hex[] = "0123456789abcdef";
+        switch (ch) {
+        case '\"':  output.append("\\\"");  break;
+        case '\\':  output.append("\\\\");  break;
+        case '\b':  output.append("\\b");   break;
+        case '\f':  output.append("\\f");   break;
+        case '\n':  output.append("\\n");   break;
+        case '\r':  output.append("\\r");   break;
+        case '\t':  output.append("\\t");   break;
+        default:
+            output.append("\\u00");
+            output.push_back(hex[ch >> 4]);
+            output.push_back(hex[ch & 0x0F]);
+            break;
+        }
+    }
+};
+
+/// Escapes a value to be used as a CSV field (RFC 4180).
+/// If the value contains commas, quotes or new lines it's enclosed in
+/// double quotes and its quotes are doubled, otherwise it's left untouched.
+///
+struct CsvEscape {
+    static bool isSafe(unsigned char ch) {
+        return ch != '\"';
+    }
+
+    static void escape(std::string& output, unsigned char) {
+        output.append("\"\"");
+    }
+
+    static bool needsQuotes(const char* data, std::size_t size) {
+        for (std::size_t i = 0; i < size; ++i) {
+            switch (data[i]) {
+            case ',': case '\"': case '\r': case '\n':
+                return true;
+            default:
+                break;
+            }
+        }
+        return false;
+    }
+};
+
+/// Percent-encodes everything but the URL unreserved characters
+/// (RFC 3986: letters, digits, "-", ".", "_" and "~").
+///
+struct UrlEscape {
+    static bool isSafe(unsigned char ch) {
+        return (ch < 0x80 && std::isalnum(ch)) ||
+               ch == '-' || ch == '.' || ch == '_' || ch == '~';
+    }
+
+    static void escape(std::string& output, unsigned char ch) {
+        static const char hex[] = "0123456789ABCDEF";
+        output.push_back('%');
+        output.push_back(hex[ch >> 4]);
+        output.push_back(hex[ch & 0x0F]);
+    }
+};
+
+/// CSV fields are quoted as a whole, so they need a specialization.
+template <>
+inline void escapeAppend<CsvEscape>(std::string& output, const char* data, std::size_t size) {
+    if (!CsvEscape::needsQuotes(data, size)) {
+        output.append(data, size);
+        return;
+    }
+    output.push_back('\"');
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        if (!CsvEscape::isSafe(static_cast<unsigned char>(data[i]))) {
+            output.append(data + start, i - start);
+            CsvEscape::escape(output, static_cast<unsigned char>(data[i]));
+            start = i + 1;
+        }
+    }
+    output.append(data + start, size - start);
+    output.push_back('\"');
+}
+
+/// Leaves everything as it is.
+struct NoEscape {
+    static bool isSafe(unsigned char) {
+        return true;
+    }
+
+    static void escape(std::string&, unsigned char) {
+    }
+};
+
+template <>
+inline void escapeAppend<NoEscape>(std::string& output, const char* data, std::size_t size) {
+    output.append(data, size);
+}
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-exception.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Exceptions thrown by Mustache.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <stdexcept>
+
+namespace mustache {
+
+/// An exception specific for Mustache.
+/// It's used to signal to application:
+/// * Variables not found
+/// * Files (or partials) not found
+/// * Wrong characters in tags
+/// * Syntax errors
+///
+class RenderException : public std::runtime_error {
+  public:
+    // Public part
+
+    /// Construct a RenderException object.
+    ///
+    /// @param what
+    ///      Error message
+    ///
+    explicit RenderException(const std::string& what) :
+            std::runtime_error(what) {
+    }
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
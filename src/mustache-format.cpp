@@ -0,0 +1,193 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-format.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Allocation-free formatting of scalar values.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-format.hpp"
+#include "./json.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+namespace mustache {
+
+void appendUnsigned(std::string& output, std::uint64_t value) {
+    // 20 digits are enough for 2^64 - 1
+    char buffer[20];
+    char* end = buffer + sizeof(buffer);
+    char* begin = end;
+    do {
+        *--begin = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    output.append(begin, end - begin);
+}
+
+void appendInteger(std::string& output, std::int64_t value) {
+    if (value < 0) {
+        output.push_back('-');
+        // Avoid overflow on the minimum value
+        appendUnsigned(output, static_cast<std::uint64_t>(-(value + 1)) + 1);
+    } else {
+        appendUnsigned(output, static_cast<std::uint64_t>(value));
+    }
+}
+
+namespace {
+
+/// Powers of ten up to NUMBER_FORMAT_MAX_DECIMALS, all exact as double.
+const double POWERS_OF_10[NUMBER_FORMAT_MAX_DECIMALS + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20
+};
+
+/// Largest scaled value formatted without printf: its integer part and
+/// its fraction are both exact as double.
+const double MAX_EXACT_SCALED = 2251799813685248.0;  // 2^51
+
+/// Writes the shortest representation of value that round-trips into
+/// [first, last) and returns the end of the written characters.
+///
+/// This is the only use of nlohmann::json internals: it is the Grisu2
+/// implementation behind json::dump(), so floats render exactly as the
+/// JSON library serializes them. It is not part of the library public
+/// interface, so if a json update moves or changes it this is the one
+/// place to replace (with a vendored dtoa, for example). The buffer must
+/// hold at least 64 characters, as in the JSON serializer.
+char* shortestDouble(char* first, char* last, double value) {
+    return nlohmann::detail::to_chars(first, last, value);
+}
+
+}  // namespace
+
+void appendFloat(std::string& output, double value) {
+    if (!std::isfinite(value)) {
+        output.append("null");
+        return;
+    }
+    char buffer[64];
+    char* end = shortestDouble(buffer, buffer + sizeof(buffer), value);
+    output.append(buffer, end - buffer);
+}
+
+void appendFixed(std::string& output, double value, int decimals) {
+    if (!std::isfinite(value)) {
+        output.append("null");
+        return;
+    }
+    // Like printf, the sign of negative values rounded to zero is kept
+    if (std::signbit(value)) {
+        output.push_back('-');
+    }
+    const double absolute = std::fabs(value);
+    const double scaled = absolute * POWERS_OF_10[decimals];
+    if (scaled >= MAX_EXACT_SCALED) {
+        // Too large to round in a double: let printf round it and take
+        // only its digits, whatever decimal point LC_NUMERIC defines
+        char buffer[320 + NUMBER_FORMAT_MAX_DECIMALS];
+        int size = std::snprintf(buffer, sizeof(buffer), "%.*f", decimals, absolute);
+        if (size <= 0) {
+            return;
+        }
+        const char* end = buffer + size;
+        const char* integer = buffer;
+        while (integer < end && *integer >= '0' && *integer <= '9') {
+            ++integer;
+        }
+        output.append(buffer, integer - buffer);
+        if (decimals > 0) {
+            output.push_back('.');
+            output.append(end - decimals, decimals);
+        }
+        return;
+    }
+    // The product is scaled + error exactly, so rounding to nearest (ties
+    // to even, as printf does) compares the exact fraction with 0.5
+    const double error = std::fma(absolute, POWERS_OF_10[decimals], -scaled);
+    const double rounded = std::floor(scaled);
+    const double above = ((scaled - rounded) - 0.5) + error;
+    std::uint64_t digits = static_cast<std::uint64_t>(rounded);
+    if (above > 0 || (above == 0 && digits % 2 != 0)) {
+        ++digits;
+    }
+    // At most 16 integer digits plus decimals plus the decimal point
+    char buffer[24 + NUMBER_FORMAT_MAX_DECIMALS];
+    char* end = buffer + sizeof(buffer);
+    char* begin = end;
+    for (int i = 0; i < decimals; ++i) {
+        *--begin = static_cast<char>('0' + digits % 10);
+        digits /= 10;
+    }
+    if (decimals > 0) {
+        *--begin = '.';
+    }
+    do {
+        *--begin = static_cast<char>('0' + digits % 10);
+        digits /= 10;
+    } while (digits != 0);
+    output.append(begin, end - begin);
+}
+
+void appendFixed(std::string& output, std::int64_t value, int decimals) {
+    appendInteger(output, value);
+    if (decimals > 0) {
+        output.push_back('.');
+        output.append(decimals, '0');
+    }
+}
+
+void appendFixed(std::string& output, std::uint64_t value, int decimals) {
+    appendUnsigned(output, value);
+    if (decimals > 0) {
+        output.push_back('.');
+        output.append(decimals, '0');
+    }
+}
+
+bool parseNumberFormat(const char* format, std::size_t size, int& decimals) {
+    if (size < 2 || size > 3 || format[0] != '.') {
+        return false;
+    }
+    decimals = 0;
+    for (std::size_t i = 1; i < size; ++i) {
+        if (format[i] < '0' || format[i] > '9') {
+            return false;
+        }
+        decimals = decimals * 10 + (format[i] - '0');
+    }
+    return decimals <= NUMBER_FORMAT_MAX_DECIMALS;
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
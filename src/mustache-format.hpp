@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-format.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Allocation-free formatting of scalar values.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace mustache {
+
+/// Separates the variable name from its number format.
+/// Eg: {{ price:.2 }} prints price with two decimals.
+const char NUMBER_FORMAT_SEPARATOR = ':';
+
+/// Maximum number of decimals allowed in a number format.
+const int NUMBER_FORMAT_MAX_DECIMALS = 20;
+
+/// Means "no number format": numbers are printed as the JSON library does.
+const int NUMBER_FORMAT_DEFAULT = -1;
+
+/// Appends a signed integer to output.
+void appendInteger(std::string& output, std::int64_t value);
+
+/// Appends an unsigned integer to output.
+void appendUnsigned(std::string& output, std::uint64_t value);
+
+/// Appends a floating point number to output using the shortest
+/// representation that round-trips (the same as nlohmann::json::dump).
+/// NaN and infinite values are printed as "null".
+void appendFloat(std::string& output, double value);
+
+/// Appends a floating point number to output with a fixed number of
+/// decimals, rounded like printf("%.*f") (half-way cases to even).
+/// The decimal point is always '.', whatever the C locale (LC_NUMERIC).
+/// NaN and infinite values are printed as "null".
+void appendFixed(std::string& output, double value, int decimals);
+
+/// Appends a signed integer to output with a fixed number of decimals
+/// (all zeros).
+void appendFixed(std::string& output, std::int64_t value, int decimals);
+
+/// Appends an unsigned integer to output with a fixed number of decimals
+/// (all zeros).
+void appendFixed(std::string& output, std::uint64_t value, int decimals);
+
+/// Parses a number format (the part after NUMBER_FORMAT_SEPARATOR).
+///
+/// @param format
+///     The format to parse. The only supported format is ".N" (fixed
+///     N decimals, with 0 <= N <= NUMBER_FORMAT_MAX_DECIMALS).
+/// @param decimals
+///     Filled with the number of decimals.
+///
+/// @return
+///     true if the format is valid.
+///
+bool parseNumberFormat(const char* format, std::size_t size, int& decimals);
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
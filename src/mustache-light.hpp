@@ -37,78 +37,47 @@
 
 #include <string>
 #include <vector>
-#include <map>
-#include <stack>
-#include <stdexcept>
 
 #include "json.hpp"
+#include "mustache-exception.hpp"
+#include "mustache-escape.hpp"
+#include "mustache-format.hpp"
+#include "mustache-template.hpp"
+#include "mustache-allocation.hpp"
+#include "mustache-stats.hpp"
+#include "mustache-profile.hpp"
+#include "mustache-observer.hpp"
+#include "mustache-metrics.hpp"
+#include "mustache-template-cache.hpp"
+#include "mustache-mapped-file.hpp"
+#include "mustache-source.hpp"
+#include "mustache-template-store.hpp"
+#include "mustache-engine.hpp"
+#include "mustache-renderer.hpp"
+#include "mustache-async-loader.hpp"
+#include "mustache-thread-pool.hpp"
+#include "mustache-batch-renderer.hpp"
+#include "mustache-watcher.hpp"
+#include "mustache-site.hpp"
 
 namespace mustache {
 
-/// An exception specific for Mustache.
-/// It's used to signal to application:
-/// * Variables not found
-/// * Files (or partials) not found
-/// * Wrong characters in tags
-/// * Syntax errors
+/// A template engine and a renderer bundled together.
 ///
-class RenderException : public std::runtime_error {
-  public:
-    // Public part
-
-    /// Construct a RenderException object.
-    ///
-    /// @param what
-    ///      Error message
-    ///
-    explicit RenderException(const std::string& what) :
-            std::runtime_error(what) {
-    }
-};
-
-/// Tokens:
-///   sv  = start variable = {{
-///   svu = start variable unescaped= {{{
-///   sc  = start comment = {{!
-///   sb  = start begin of section = {{#
-///   se  = start end of section = {{/
-///   si  = start if = {{=
-///   s0  = start existing test = {{0
-///   su  = start unless = {{^
-///   sp  = start partial = {{>
-///   st  = start template = {{<
-///   ee  = end = }}
-///   eeu = end = }}}
-///   txt = (sequence of txt)
+/// Mustache is the simplest way to render templates from a single thread.
+/// Multi-threaded applications should share a single Engine and give each
+/// thread its own Renderer (see mustache-engine.hpp and
+/// mustache-renderer.hpp for the syntax).
 ///
-/// Grammar:
-///   MESSAGE            := VARIABLE MESSAGE | VARIABLE_UNESCAPED MESSAGE |
-///                         COMMENT MESSAGE | SECTION MESSAGE |
-///                         IF MESSAGE | UNLESS MESSAGE | EXISTS_TEST MESSAGE |
-///                         PARTIAL MESSAGE | txt MESSAGE | (empty)
-///   VARIABLE           := sv  txt ee
-///   VARIABLE_UNESCAPED := svu txt eeu
-///   COMMENT            := sc  txt ee
-///   IF                 := si  txt ee
-///   EXISTS_TEST        := s0  txt ee
-///   UNLESS             := sv  txt ee
-///   SECTION            := sb  txt ee MESSAGE se txt ee | sbi txt ee MESSAGE se txt ee
-///   PARTIAL            := sp  txt ee | st txt ee
+/// Template files (views and partials) are compiled once and cached for
+/// the lifetime of the object: edits to the files are not seen until
+/// clearCache() is called (or the engine is reloaded, see Engine::reload()
+/// and TemplateWatcher).
 ///
 class Mustache {
   public:
     // Public part
 
-    // Some types (useful for readability purposes)
-    // basically we uses sting and string containers.
-
-    typedef std::map<std::string, std::string> Variables;
-    typedef Variables::iterator VariableIterator;
-    typedef Variables::const_iterator VariableConstIterator;
-    typedef std::string Token;
-    typedef std::vector<Token> Tokens;
-    typedef long unsigned int TokenIndex;
-
     /// Construct a new Mustache object, using basePath as base partial
     /// search path.
     ///
@@ -127,6 +96,39 @@ class Mustache {
     ///
     Mustache(const std::string& basePath, const std::string& partialExtension);
 
+    /// Construct a new Mustache object, using basePath as base partial
+    /// search path.
+    ///
+    /// @param basePath
+    ///     Base path for file searching. Must be an absolute path.
+    /// @param partialExtension
+    ///     Default extension for partials.
+    /// @param escape
+    ///     Escape policy used for escaped variables {{ var }}.
+    ///
+    Mustache(const std::string& basePath, const std::string& partialExtension,
+             Escape escape);
+
+    /// Construct a new Mustache object, using basePath as base partial
+    /// search path.
+    ///
+    /// @param basePath
+    ///     Base path for file searching. Must be an absolute path.
+    /// @param options
+    ///     Engine options (Eg: to enable parallel rendering).
+    ///
+    Mustache(const std::string& basePath, const EngineOptions& options);
+
+    /// Construct a new Mustache object searching files in a list of
+    /// directories (see SearchPathSource).
+    ///
+    /// @param searchPath
+    ///     The directories, in search order (Eg: overrides first).
+    /// @param options
+    ///     Engine options (source is replaced).
+    ///
+    Mustache(const std::vector<std::string>& searchPath, const EngineOptions& options);
+
     /// Destructor for Mustache object.
     ~Mustache();
 
@@ -161,153 +163,71 @@ class Mustache {
     ///
     std::string error() const;
 
+    /// Renders a template file with a JSON context file.
+    ///
+    /// @param viewFileName
+    ///     File name of the view relative to base path, without extension.
+    ///     The view is compiled once and cached (see clearCache()).
+    /// @param contextFileName
+    ///     File name of the context relative to base path, without the
+    ///     ".json" extension. It's read on every call.
+    ///
+    /// @return
+    ///     The rendered template.
+    ///
     std::string renderFilenames(const std::string& viewFileName, const std::string& contextFileName);
 
+    /// Removes all the compiled templates from the cache: views and
+    /// partials are read again from their files by the following renders.
+    void clearCache();
+
     std::string fileRead(const std::string& fileName, const std::string& fileExtension);
     std::string fileRead(const std::string& fileName);
 
-  private:
-    /// List of valid characters for an identifier.
-    static const std::string VALID_CHARS_FOR_ID;
-
-    /// List of all valid characters for partial tag.
-    static const std::string VALID_CHARS_FOR_PARTIALS;
-
-    // List of valid tokens
-    static const std::string TOKEN_START_VARIABLE;
-    static const std::string TOKEN_START_VARIABLE_UNESCAPED;
-    static const std::string TOKEN_START_COMMENT;
-    static const std::string TOKEN_START_BEGIN_SECTION;
-    static const std::string TOKEN_START_END_SECTION;
-    static const std::string TOKEN_START_IF;
-    static const std::string TOKEN_START_EXISTS_TEST;
-    static const std::string TOKEN_START_UNLESS;
-    static const std::string TOKEN_START_PARTIAL;
-    static const std::string TOKEN_START_TEMPLATE;
-    static const std::string TOKEN_END;
-    static const std::string TOKEN_END_UNESCAPED;
-
-    /// Default extension to be used for partials
-    static const std::string DEFAULT_PARTIAL_EXTENSION;
-
-    /// Base path is added to file name each time a file must be opened.
-    std::string basePath_;
-
-    std::string partialExtension_;
-
-    /// The HTML template containing tags to evaluate {{ ... }}
-    std::string view_;
-
-    /// The context
-    std::string context_;
-
-    nlohmann::json data_;
-
-    /// Stores render result
-    std::string rendered_;
-
-    /// Stores error message
-    std::string error_;
-
-    Tokens tokens_;
-
-    TokenIndex currentToken_;
-
-    std::size_t currentListCounter_;
+    /// The engine used by this object.
+    const Engine& engine() const;
 
-    /// Used to manage sections.
-    /// When a block {{# var }} ... {{/ var }} is found the parser should
-    /// iterate inside it.
-    std::stack<nlohmann::json> stack_;
-
-    /// Used to hide/view a section
-    bool visible_;
-
-    /// Starts the rendering process.
-    /// This is the first method called after parameter read.
-    std::string render();
-
-    /// Used for debugging purposes
-    Tokens tokenize(const std::string& view);
-
-    // Productions
-    void produceMessage();
-    void produceVariable();
-    void produceVariableUnescaped();
-    void produceComment();
-    void produceSection();
-    void produceIf();
-    void produceUnless();
-    void produceNullTest();
-    void producePartial();
-
-    void printVariable(bool escape_html);
-
-    void partialSubstitute(const Tokens partialParams, Tokens& newTokens);
-
-    /// Searches a variable inside a Variable list.
-    ///
-    /// @param  variables     The variable list
-    /// @param  valueToSearch The key to search for
+    /// Enables statistics of the following renders (see
+    /// Renderer::setStats()). The time spent compiling the view is added
+    /// to the tokenize time.
     ///
-    /// @return               A VariableConstIterator pointer to pair found,
-    ///                       or variable_.end() if nothing is found.
+    /// @param stats
+    ///     The statistics to fill, or nullptr to disable them.
     ///
-    VariableConstIterator partialSearchVariable(const Variables& variables,
-        const std::string& valueToSearch);
+    void setStats(RenderStats* stats);
 
-    /// Throws an exception and stops rendering.
-    [[noreturn]] void error(const std::string& message);
-
-    /// Variable get in the current context
-    ///
-    /// @param key
-    ///     The key to serch in the current context.
+    /// Enables profiling of the following renders (see
+    /// Renderer::setProfile()).
     ///
-    /// @returns
-    ///     The value of the corresponding key (as json object)
+    /// @param profile
+    ///     The profile, or nullptr to disable profiling.
+    /// @param viewName
+    ///     Name of the views in the profile.
     ///
-    /// @throws std::out_of_range
-    ///     If the context is an array and the index is out of bounds.
-    /// @throws std::invalid_argument
-    ///     If the the key is not found in the key.
-    ///
-    nlohmann::json searchVariableInContext(const std::string& key);
-
-    std::string getTemplateNameFromContext(const std::string& key);
+    void setProfile(Profile* profile, const std::string& viewName = "(view)");
 
-    /// A valid identifier <em>must</em> contain only lowercase characters,
-    /// decimal digits and minus (-). No space or other characters allowed.
+    /// Adds the following renders to metrics (see Renderer::setMetrics()).
     ///
-    /// @param id
-    ///     The std::string to check.
+    /// @param metrics
+    ///     The metrics, or nullptr to disable them.
+    /// @param viewName
+    ///     Name of the views in the metrics.
     ///
-    /// @throws RenderError
-    ///     If the identifier is not valid.
-    void ensureValidIdentifier(const std::string& id, const std::string& validChars = VALID_CHARS_FOR_ID);
+    void setMetrics(Metrics* metrics, const std::string& viewName = "(view)");
 
-    std::vector<std::string>& split(const std::string &s, char delim, std::vector<std::string> &elems);
-    std::vector<std::string> split(const std::string &s, char delim);
-
-#ifdef DEBUG
-    // Dump tokens.
-    void dumpTokens();
-
-    // Dump partial variables.
-    void dumpVariables();
-#endif
-
-    // trim from start
-    std::string& ltrim(std::string& s);
+  private:
+    /// Configuration and compiled templates
+    Engine engine_;
 
-    // trim from end
-    std::string &rtrim(std::string& s);
+    /// Per-render state (uses engine_)
+    Renderer renderer_;
 
-    // trim from both ends
-    std::string& trim(std::string& s);
+    /// See setStats()
+    RenderStats* stats_;
 
-    // Escapes dangerous characters
-    void htmlEscape(std::string& stringToEscape);
+    /// Compiles view and renders it with context.
+    template <class Context>
+    std::string renderView(const std::string& view, const Context& context);
 
     // Disallow default constructor, copy constructor and assign operator
     Mustache();
@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-mapped-file.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Read-only memory mapped files.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-mapped-file.hpp"
+
+#include <string>
+using std::string;
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mustache {
+
+MappedFilePtr MappedFile::open(const string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return MappedFilePtr();
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return MappedFilePtr();
+    }
+    if (info.st_size == 0) {
+        // Empty files cannot be mapped
+        ::close(fd);
+        return MappedFilePtr(new MappedFile(nullptr, 0));
+    }
+    void* data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after close
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return MappedFilePtr();
+    }
+    return MappedFilePtr(new MappedFile(static_cast<const char*>(data), info.st_size));
+}
+
+MappedFile::MappedFile(const char* data, std::size_t size) :
+        data_(data), size_(size) {
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
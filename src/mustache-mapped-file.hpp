@@ -0,0 +1,96 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-mapped-file.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Read-only memory mapped files.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+namespace mustache {
+
+class MappedFile;
+
+typedef std::shared_ptr<const MappedFile> MappedFilePtr;
+
+/// A file mapped read-only in memory.
+///
+/// The pages belong to the file system cache, so they are shared by all
+/// the processes mapping the file. The file must not be truncated while
+/// it's mapped: replace it by renaming a new file instead.
+///
+class MappedFile {
+  public:
+    // Public part
+
+    /// Maps a file.
+    ///
+    /// @param path
+    ///     The file path.
+    ///
+    /// @return
+    ///     The mapped file or nullptr if the file cannot be opened.
+    ///
+    static MappedFilePtr open(const std::string& path);
+
+    ~MappedFile();
+
+    /// The file contents (nullptr for empty files).
+    const char* data() const {
+        return data_;
+    }
+
+    /// The file size.
+    std::size_t size() const {
+        return size_;
+    }
+
+  private:
+    // Private part
+
+    const char* data_;
+    std::size_t size_;
+
+    MappedFile(const char* data, std::size_t size);
+
+    // Disallow default constructor, copy constructor and assign operator
+    MappedFile();
+    MappedFile(const MappedFile&);
+    void operator=(const MappedFile&);
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
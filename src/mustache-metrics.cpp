@@ -0,0 +1,264 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-metrics.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Cumulative render metrics for long-running services.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-metrics.hpp"
+
+#include <string>
+using std::string;
+#include <atomic>
+#include <algorithm>
+#include <sstream>
+
+namespace mustache {
+
+string renderResultText(RenderResult result) {
+    switch (result) {
+    case RenderResult::Ok:              return "ok";
+    case RenderResult::ContextError:    return "context_error";
+    case RenderResult::PartialError:    return "partial_error";
+    case RenderResult::TemplateError:   return "template_error";
+    }
+    return "unknown";
+}
+
+// Bounds in microseconds, from a fast partial to a slow page
+static const long long LATENCY_BOUNDS[LATENCY_BUCKETS - 1] = {
+    10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 100000
+};
+
+std::chrono::nanoseconds latencyBound(std::size_t bucket) {
+    if (bucket + 1 >= LATENCY_BUCKETS) {
+        return std::chrono::nanoseconds::max();
+    }
+    return std::chrono::microseconds(LATENCY_BOUNDS[bucket]);
+}
+
+TemplateMetrics::TemplateMetrics() :
+        latencySum(std::chrono::nanoseconds::zero()), bytesEmitted(0),
+        partialHits(0), partialMisses(0), lookups(0), misses(0) {
+    std::fill(results, results + RENDER_RESULTS, 0);
+    std::fill(latency, latency + LATENCY_BUCKETS, 0);
+}
+
+void TemplateMetrics::merge(const TemplateMetrics& other) {
+    for (std::size_t i = 0; i < RENDER_RESULTS; ++i) {
+        results[i] += other.results[i];
+    }
+    for (std::size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+        latency[i] += other.latency[i];
+    }
+    latencySum += other.latencySum;
+    bytesEmitted += other.bytesEmitted;
+    partialHits += other.partialHits;
+    partialMisses += other.partialMisses;
+    lookups += other.lookups;
+    misses += other.misses;
+}
+
+std::size_t TemplateMetrics::renders() const {
+    std::size_t all = 0;
+    for (std::size_t i = 0; i < RENDER_RESULTS; ++i) {
+        all += results[i];
+    }
+    return all;
+}
+
+double TemplateMetrics::cacheHitRate() const {
+    const std::size_t loads = partialHits + partialMisses;
+    return loads == 0 ? 0.0 : static_cast<double>(partialHits) / static_cast<double>(loads);
+}
+
+TemplateMetrics MetricsSnapshot::total() const {
+    TemplateMetrics all;
+    for (const MetricsSnapshot::Templates::value_type& view : templates) {
+        all.merge(view.second);
+    }
+    return all;
+}
+
+// Label values escape backslashes, quotes and new lines
+static void appendLabel(std::ostringstream& out, const string& value) {
+    for (const char ch : value) {
+        switch (ch) {
+        case '\\':  out << "\\\\";  break;
+        case '\"':  out << "\\\"";  break;
+        case '\n':  out << "\\n";   break;
+        default:    out << ch;      break;
+        }
+    }
+}
+
+static void appendHeader(std::ostringstream& out, const string& name,
+                         const char* type, const char* help) {
+    out << "# HELP " << name << ' ' << help << '\n';
+    out << "# TYPE " << name << ' ' << type << '\n';
+}
+
+// One counter per template
+template <class Value>
+static void appendCounter(std::ostringstream& out, const MetricsSnapshot& snapshot,
+                          const string& name, const char* help, Value value) {
+    appendHeader(out, name, "counter", help);
+    for (const MetricsSnapshot::Templates::value_type& view : snapshot.templates) {
+        out << name << "{template=\"";
+        appendLabel(out, view.first);
+        out << "\"} " << value(view.second) << '\n';
+    }
+}
+
+string MetricsSnapshot::prometheus(const string& prefix) const {
+    std::ostringstream out;
+    out.precision(9);
+
+    const string renders = prefix + "_renders_total";
+    appendHeader(out, renders, "counter", "Renders by template and result.");
+    for (const MetricsSnapshot::Templates::value_type& view : templates) {
+        for (std::size_t i = 0; i < RENDER_RESULTS; ++i) {
+            out << renders << "{template=\"";
+            appendLabel(out, view.first);
+            out << "\",result=\"" << renderResultText(static_cast<RenderResult>(i))
+                << "\"} " << view.second.results[i] << '\n';
+        }
+    }
+
+    const string duration = prefix + "_render_duration_seconds";
+    appendHeader(out, duration, "histogram", "Render latency by template.");
+    for (const MetricsSnapshot::Templates::value_type& view : templates) {
+        const TemplateMetrics& metrics = view.second;
+        std::size_t cumulative = 0;
+        for (std::size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+            cumulative += metrics.latency[i];
+            out << duration << "_bucket{template=\"";
+            appendLabel(out, view.first);
+            out << "\",le=\"";
+            if (i + 1 < LATENCY_BUCKETS) {
+                out << static_cast<double>(LATENCY_BOUNDS[i]) / 1e6;
+            } else {
+                out << "+Inf";
+            }
+            out << "\"} " << cumulative << '\n';
+        }
+        out << duration << "_sum{template=\"";
+        appendLabel(out, view.first);
+        out << "\"} " << static_cast<double>(metrics.latencySum.count()) / 1e9 << '\n';
+        out << duration << "_count{template=\"";
+        appendLabel(out, view.first);
+        out << "\"} " << cumulative << '\n';
+    }
+
+    appendCounter(out, *this, prefix + "_output_bytes_total", "Bytes rendered by template.",
+                  [](const TemplateMetrics& metrics) { return metrics.bytesEmitted; });
+    appendCounter(out, *this, prefix + "_partial_cache_hits_total",
+                  "Partials found in the cache by template.",
+                  [](const TemplateMetrics& metrics) { return metrics.partialHits; });
+    appendCounter(out, *this, prefix + "_partial_cache_misses_total",
+                  "Partials read from the template source by template.",
+                  [](const TemplateMetrics& metrics) { return metrics.partialMisses; });
+    appendCounter(out, *this, prefix + "_lookups_total",
+                  "Variables looked up in the context by template.",
+                  [](const TemplateMetrics& metrics) { return metrics.lookups; });
+    appendCounter(out, *this, prefix + "_lookup_misses_total",
+                  "Variables not found in the context by template.",
+                  [](const TemplateMetrics& metrics) { return metrics.misses; });
+    return out.str();
+}
+
+Metrics::Metrics(unsigned shards) {
+    shards_.resize(std::max(shards, 1u));
+    for (std::unique_ptr<Shard>& shard : shards_) {
+        shard.reset(new Shard());
+    }
+}
+
+Metrics::~Metrics() {
+}
+
+// Threads are numbered in order of first use: consecutive threads get
+// different shards.
+static std::size_t threadIndex() {
+    static std::atomic<std::size_t> next(0);
+    static thread_local std::size_t index = next++;
+    return index;
+}
+
+void Metrics::add(const string& view, const RenderStats& stats, RenderResult result) {
+    const std::chrono::nanoseconds latency = stats.renderTime + stats.parseContextTime;
+    std::size_t bucket = 0;
+    while (latency > latencyBound(bucket)) {
+        ++bucket;
+    }
+
+    Shard& shard = *shards_[threadIndex() % shards_.size()];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    MetricsSnapshot::Templates::iterator it = shard.templates.find(view);
+    if (it == shard.templates.end()) {
+        it = shard.templates.insert(std::make_pair(view, TemplateMetrics())).first;
+    }
+    TemplateMetrics& metrics = it->second;
+    ++metrics.results[static_cast<std::size_t>(result)];
+    ++metrics.latency[bucket];
+    metrics.latencySum += latency;
+    metrics.bytesEmitted += stats.bytesEmitted;
+    metrics.partialHits += stats.partialHits;
+    metrics.partialMisses += stats.partialMisses;
+    metrics.lookups += stats.lookups;
+    metrics.misses += stats.misses;
+}
+
+MetricsSnapshot Metrics::snapshot() const {
+    MetricsSnapshot snapshot;
+    for (const std::unique_ptr<Shard>& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const MetricsSnapshot::Templates::value_type& view : shard->templates) {
+            snapshot.templates[view.first].merge(view.second);
+        }
+    }
+    return snapshot;
+}
+
+string Metrics::prometheus(const string& prefix) const {
+    return snapshot().prometheus(prefix);
+}
+
+void Metrics::clear() {
+    for (const std::unique_ptr<Shard>& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->templates.clear();
+    }
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
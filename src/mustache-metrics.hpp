@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-metrics.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Cumulative render metrics for long-running services.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstddef>
+
+#include "mustache-stats.hpp"
+
+namespace mustache {
+
+/// Result of a render.
+enum class RenderResult {
+    Ok,             ///< Rendered
+    ContextError,   ///< The context is not valid JSON
+    PartialError,   ///< A partial could not be loaded
+    TemplateError   ///< Any other error (syntax, variables)
+};
+
+/// Number of render results (see RenderResult).
+const std::size_t RENDER_RESULTS = static_cast<std::size_t>(RenderResult::TemplateError) + 1;
+
+/// Name of a render result (Eg: "partial_error").
+std::string renderResultText(RenderResult result);
+
+/// Number of buckets of the latency histograms (the last one is unbounded).
+const std::size_t LATENCY_BUCKETS = 13;
+
+/// Upper bound of a bucket of the latency histograms (nanoseconds::max()
+/// for the last one).
+std::chrono::nanoseconds latencyBound(std::size_t bucket);
+
+/// Cumulative metrics of the renders of a template.
+struct TemplateMetrics {
+    /// All counters and times are zero.
+    TemplateMetrics();
+
+    /// Adds counters and times of other.
+    void merge(const TemplateMetrics& other);
+
+    /// All the renders, whatever the result.
+    std::size_t renders() const;
+
+    /// Renders with a result.
+    std::size_t count(RenderResult result) const {
+        return results[static_cast<std::size_t>(result)];
+    }
+
+    /// Partials found in the cache out of the partials loaded (0 if none).
+    double cacheHitRate() const;
+
+    /// See count()
+    std::size_t results[RENDER_RESULTS];
+
+    /// Renders by latency: latency[i] counts the renders slower than the
+    /// bound of bucket i - 1 and not slower than the bound of bucket i.
+    std::size_t latency[LATENCY_BUCKETS];
+
+    /// Total time of the renders
+    std::chrono::nanoseconds latencySum;
+
+    /// Size of the outputs
+    std::size_t bytesEmitted;
+
+    /// Partials found in the cache, and read from the template source
+    std::size_t partialHits;
+    std::size_t partialMisses;
+
+    /// Variables and sections looked up, and not found
+    std::size_t lookups;
+    std::size_t misses;
+};
+
+/// Metrics of a Metrics object at a point in time.
+struct MetricsSnapshot {
+    /// Metrics by template name.
+    typedef std::map<std::string, TemplateMetrics> Templates;
+
+    Templates templates;
+
+    /// Metrics of all the templates.
+    TemplateMetrics total() const;
+
+    /// The metrics in the Prometheus text exposition format, labelled by
+    /// template (and by result for the renders).
+    ///
+    /// @param prefix
+    ///     Prefix of the metric names (Eg: "mustache_renders_total").
+    ///
+    std::string prometheus(const std::string& prefix = "mustache") const;
+};
+
+/// Cumulative render metrics by template: renders by result, latency
+/// histograms, output bytes, cache hits and context lookups (see
+/// Renderer::setMetrics()).
+///
+/// Renderers of any thread can share a Metrics object. Each thread adds
+/// to its own shard, so concurrent renders rarely contend: shards are
+/// merged only by snapshot().
+///
+class Metrics {
+  public:
+    // Public part
+
+    /// @param shards
+    ///     Number of shards (at least 1): threads beyond it share shards.
+    ///
+    explicit Metrics(unsigned shards = 16);
+
+    ~Metrics();
+
+    /// Adds a render of a template (thread-safe).
+    ///
+    /// @param view
+    ///     Name of the template.
+    /// @param stats
+    ///     Statistics of the render: renderTime plus parseContextTime is
+    ///     its latency.
+    /// @param result
+    ///     Result of the render.
+    ///
+    void add(const std::string& view, const RenderStats& stats, RenderResult result);
+
+    /// Metrics of all the threads so far.
+    MetricsSnapshot snapshot() const;
+
+    /// Shortcut for snapshot().prometheus(prefix).
+    std::string prometheus(const std::string& prefix = "mustache") const;
+
+    /// Removes all the metrics.
+    void clear();
+
+  private:
+    // Private part
+
+    struct Shard {
+        std::mutex mutex;
+        MetricsSnapshot::Templates templates;
+    };
+
+    std::vector<std::unique_ptr<Shard> > shards_;
+
+    // Disallow copy constructor and assign operator
+    Metrics(const Metrics&);
+    void operator=(const Metrics&);
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
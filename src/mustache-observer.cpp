@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-observer.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Observers of render lifecycle events (Eg: for tracing).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-observer.hpp"
+
+#include <string>
+using std::string;
+
+namespace mustache {
+
+RenderObserver::~RenderObserver() {
+}
+
+void RenderObserver::renderBegin(const Template&) {
+}
+
+void RenderObserver::renderEnd(const Template&, bool, std::size_t) {
+}
+
+void RenderObserver::partialResolve(const string&, const string&) {
+}
+
+void RenderObserver::partialLoad(const string&, bool, std::chrono::nanoseconds) {
+}
+
+void RenderObserver::sectionEnter(TokenKind, const string&) {
+}
+
+void RenderObserver::sectionExit(TokenKind, const string&, std::size_t) {
+}
+
+void RenderObserver::error(const string&) {
+}
+
+StreamObserver::StreamObserver(std::ostream& out) :
+        out_(out) {
+}
+
+void StreamObserver::renderBegin(const Template& view) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_ << "render begin: " << view.size() << " tokens\n";
+}
+
+void StreamObserver::renderEnd(const Template&, bool ok, std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_ << "render end: " << (ok ? "ok" : "failed") << ", " << bytes << " bytes" << std::endl;
+}
+
+void StreamObserver::partialResolve(const string& tag, const string& fileName) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_ << "partial resolve: " << tag << " -> " << fileName << "\n";
+}
+
+void StreamObserver::partialLoad(const string& fileName, bool cached,
+                                 std::chrono::nanoseconds elapsed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_ << "partial load: " << fileName << (cached ? " (cached) " : " (read) ")
+         << elapsed.count() << " ns\n";
+}
+
+void StreamObserver::sectionEnter(TokenKind kind, const string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_ << "section enter: " << tokenKindText(kind) << " " << name << " }}\n";
+}
+
+void StreamObserver::sectionExit(TokenKind kind, const string& name, std::size_t iterations) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_ << "section exit: " << tokenKindText(kind) << " " << name << " }}, "
+         << iterations << " iterations\n";
+}
+
+void StreamObserver::error(const string& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_ << "error: " << message << "\n";
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-observer.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Observers of render lifecycle events (Eg: for tracing).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <ostream>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <cstddef>
+
+#include "mustache-template.hpp"
+
+namespace mustache {
+
+/// Receives the events of renders, Eg: to feed a tracing system (see
+/// Renderer::setObserver() and EngineOptions::observer).
+///
+/// Functions do nothing by default: override the interesting ones.
+/// Without an observer a renderer only tests a null pointer for each event.
+/// Partials and sections rendered concurrently (see EngineOptions) send
+/// their events from the worker threads, so observers of engines using
+/// parallel features must be thread-safe.
+///
+/// A renderAsync() suspended for missing partials is one render: it
+/// begins once and ends when it completes. The sections and partials of
+/// a suspended pass are reported again by the pass that resumes it.
+///
+class RenderObserver {
+  public:
+    // Public part
+
+    virtual ~RenderObserver();
+
+    /// A render starts.
+    virtual void renderBegin(const Template& view);
+
+    /// A render ends.
+    ///
+    /// @param view
+    ///     The template rendered.
+    /// @param ok
+    ///     false if the render failed (see error()).
+    /// @param bytes
+    ///     Size of the output.
+    ///
+    virtual void renderEnd(const Template& view, bool ok, std::size_t bytes);
+
+    /// A partial tag was resolved to a file name.
+    ///
+    /// @param tag
+    ///     The tag (Eg: "user | Name='Mario'", or "page" for {{< page }}).
+    /// @param fileName
+    ///     The file name (for {{< page }} the value of page).
+    ///
+    virtual void partialResolve(const std::string& tag, const std::string& fileName);
+
+    /// A partial was loaded.
+    ///
+    /// @param fileName
+    ///     The file name.
+    /// @param cached
+    ///     false if the file was read from the template source.
+    /// @param elapsed
+    ///     Time spent loading (and compiling) it.
+    ///
+    virtual void partialLoad(const std::string& fileName, bool cached,
+                             std::chrono::nanoseconds elapsed);
+
+    /// A section ({{#, {{=, {{^ or {{0) starts.
+    ///
+    /// @param kind
+    ///     The start token (Eg: TokenKind::StartBeginSection).
+    /// @param name
+    ///     The section variable.
+    ///
+    virtual void sectionEnter(TokenKind kind, const std::string& name);
+
+    /// A section ends (not called if it fails).
+    ///
+    /// @param kind
+    ///     The start token.
+    /// @param name
+    ///     The section variable.
+    /// @param iterations
+    ///     Times the section body was rendered: 0 if hidden, the number of
+    ///     items for arrays, 1 otherwise.
+    ///
+    virtual void sectionExit(TokenKind kind, const std::string& name, std::size_t iterations);
+
+    /// A render failed (called before renderEnd()).
+    virtual void error(const std::string& message);
+};
+
+typedef std::shared_ptr<RenderObserver> RenderObserverPtr;
+
+/// Writes every event to a stream, one line each (Eg: for debugging).
+/// Thread-safe.
+///
+class StreamObserver : public RenderObserver {
+  public:
+    // Public part
+
+    /// Construct a StreamObserver.
+    ///
+    /// @param out
+    ///     The stream. It must outlive the observer.
+    ///
+    explicit StreamObserver(std::ostream& out);
+
+    void renderBegin(const Template& view) override;
+    void renderEnd(const Template& view, bool ok, std::size_t bytes) override;
+    void partialResolve(const std::string& tag, const std::string& fileName) override;
+    void partialLoad(const std::string& fileName, bool cached,
+                     std::chrono::nanoseconds elapsed) override;
+    void sectionEnter(TokenKind kind, const std::string& name) override;
+    void sectionExit(TokenKind kind, const std::string& name, std::size_t iterations) override;
+    void error(const std::string& message) override;
+
+  private:
+    // Private part
+
+    std::ostream& out_;
+
+    /// Lines of concurrent renders are not mixed
+    std::mutex mutex_;
+
+    // Disallow copy constructor and assign operator
+    StreamObserver(const StreamObserver&);
+    void operator=(const StreamObserver&);
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
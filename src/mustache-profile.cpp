@@ -0,0 +1,169 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-profile.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Per-tag profiling of renders.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-profile.hpp"
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+namespace mustache {
+
+Profile::Profile() :
+        renders_(0), time_(std::chrono::nanoseconds::zero()) {
+}
+
+/// false if a site measured in both a and b has a different description.
+static bool sameSites(const Profile::Sites& a, const Profile::Sites& b) {
+    const std::size_t size = std::min(a.size(), b.size());
+    for (std::size_t i = 0; i < size; ++i) {
+        if (a[i].count > 0 && b[i].count > 0 &&
+                (a[i].line != b[i].line || a[i].column != b[i].column || a[i].tag != b[i].tag)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Profile::add(const Files& files, const Stacks& stacks, std::chrono::nanoseconds time) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Files::const_iterator file = files.begin(); file != files.end(); ++file) {
+        // Different templates can have the same name (Eg: views rendered
+        // with the default name): their sites are kept apart
+        Sites* other = &files_[file->first];
+        for (unsigned n = 2; !sameSites(*other, file->second); ++n) {
+            other = &files_[file->first + "#" + std::to_string(n)];
+        }
+        Sites& sites = *other;
+        if (sites.size() < file->second.size()) {
+            sites.resize(file->second.size(), ProfileSite());
+        }
+        for (std::size_t i = 0; i < file->second.size(); ++i) {
+            const ProfileSite& measure = file->second[i];
+            if (measure.count == 0) {
+                continue;
+            }
+            ProfileSite& site = sites[i];
+            if (site.count == 0) {
+                site = measure;
+            } else {
+                site.count += measure.count;
+                site.time += measure.time;
+                site.bytes += measure.bytes;
+            }
+        }
+    }
+    for (Stacks::const_iterator stack = stacks.begin(); stack != stacks.end(); ++stack) {
+        stacks_[stack->first] += stack->second;
+    }
+    ++renders_;
+    time_ += time;
+}
+
+std::size_t Profile::renders() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return renders_;
+}
+
+std::chrono::nanoseconds Profile::time() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return time_;
+}
+
+vector<ProfileSite> Profile::sites() const {
+    vector<ProfileSite> all;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Files::const_iterator file = files_.begin(); file != files_.end(); ++file) {
+            for (const ProfileSite& site : file->second) {
+                if (site.count > 0) {
+                    all.push_back(site);
+                }
+            }
+        }
+    }
+    std::stable_sort(all.begin(), all.end(), [](const ProfileSite& a, const ProfileSite& b) {
+        return a.time > b.time;
+    });
+    return all;
+}
+
+string Profile::report(std::size_t limit) const {
+    const vector<ProfileSite> all = sites();
+    const double total = static_cast<double>(time().count());
+
+    std::ostringstream out;
+    out << "Renders: " << renders() << ", time: " << std::fixed << std::setprecision(3)
+        << total / 1e6 << " ms\n";
+    out << std::setw(12) << "time ms" << std::setw(8) << "%" << std::setw(10) << "count"
+        << std::setw(12) << "bytes" << "  site\n";
+    for (std::size_t i = 0; i < all.size() && (limit == 0 || i < limit); ++i) {
+        const ProfileSite& site = all[i];
+        const double time = static_cast<double>(site.time.count());
+        out << std::setw(12) << std::setprecision(3) << time / 1e6
+            << std::setw(7) << std::setprecision(1) << (total > 0 ? time * 100.0 / total : 0.0) << "%"
+            << std::setw(10) << site.count << std::setw(12) << site.bytes
+            << "  " << site.file << ":" << site.line << ":" << site.column << " " << site.tag << "\n";
+    }
+    return out.str();
+}
+
+string Profile::foldedStacks() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    string folded;
+    for (Stacks::const_iterator stack = stacks_.begin(); stack != stacks_.end(); ++stack) {
+        folded += stack->first;
+        folded += ' ';
+        folded += std::to_string(stack->second.count());
+        folded += '\n';
+    }
+    return folded;
+}
+
+void Profile::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_.clear();
+    stacks_.clear();
+    renders_ = 0;
+    time_ = std::chrono::nanoseconds::zero();
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-profile.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Per-tag profiling of renders.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstddef>
+
+namespace mustache {
+
+/// Measures of a tag site: a tag in a template file, with everything it
+/// renders (nested tags, section items, partials).
+struct ProfileSite {
+    /// Template file name (with partial parameters, if any) or view name
+    std::string file;
+
+    /// Position of the tag in the file (1-based, 0 if unknown)
+    std::size_t line;
+    std::size_t column;
+
+    /// The tag (Eg: "{{# items }}")
+    std::string tag;
+
+    /// Times the tag was rendered
+    std::size_t count;
+
+    /// Time spent rendering the tag (nested tags included)
+    std::chrono::nanoseconds time;
+
+    /// Output bytes produced by the tag (nested tags included)
+    std::size_t bytes;
+};
+
+/// Render time and output bytes by tag site, collected across many renders
+/// (see Renderer::setProfile()). Renderers of different threads can share
+/// a Profile: each one adds its measures at the end of a render.
+///
+/// While profiling partials and sections are rendered sequentially, so
+/// times add up.
+///
+class Profile {
+  public:
+    // Public part
+
+    /// Sites of a template file by token index (count is 0 for tokens
+    /// never rendered).
+    typedef std::vector<ProfileSite> Sites;
+
+    /// Sites by template file. Sites of different templates with the same
+    /// name are kept under "name#2", "name#3"... (ProfileSite::file is the
+    /// name).
+    typedef std::map<std::string, Sites> Files;
+
+    /// Self time by stack of partials (Eg: "page;layout;user").
+    typedef std::map<std::string, std::chrono::nanoseconds> Stacks;
+
+    Profile();
+
+    /// Adds the measures of a render (thread-safe).
+    void add(const Files& files, const Stacks& stacks, std::chrono::nanoseconds time);
+
+    /// Number of renders added.
+    std::size_t renders() const;
+
+    /// Total time of the renders added.
+    std::chrono::nanoseconds time() const;
+
+    /// All the sites rendered, slowest first.
+    std::vector<ProfileSite> sites() const;
+
+    /// A table of the slowest sites (time, share of the total time, count,
+    /// bytes and site).
+    ///
+    /// @param limit
+    ///     Maximum number of sites (0 for all).
+    ///
+    std::string report(std::size_t limit = 20) const;
+
+    /// Self time (in nanoseconds) of each stack of partials, one stack for
+    /// each line in the folded format of flamegraph.pl:
+    /// "page;layout;user 12345".
+    std::string foldedStacks() const;
+
+    /// Removes all the measures.
+    void clear();
+
+  private:
+    // Private part
+
+    mutable std::mutex mutex_;
+
+    Files files_;
+
+    Stacks stacks_;
+
+    std::size_t renders_;
+
+    std::chrono::nanoseconds time_;
+
+    // Disallow copy constructor and assign operator
+    Profile(const Profile&);
+    void operator=(const Profile&);
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,1107 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-renderer.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Per-render state and template parser.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-renderer.hpp"
+#include "./mustache-allocation.hpp"
+#include "./mustache-async-loader.hpp"
+#include "./mustache-engine.hpp"
+#include "./mustache-exception.hpp"
+#include "./mustache-format.hpp"
+#include "./mustache-internal.hpp"
+#include "./mustache-stats.hpp"
+#include "./mustache-thread-pool.hpp"
+
+using json = nlohmann::json;
+
+#include <vector>
+using std::vector;
+#include <string>
+using std::string;
+#include <stdexcept>
+#include <map>
+using std::map;
+#include <memory>
+using std::unique_ptr;
+using std::shared_ptr;
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+
+namespace mustache {
+
+// Returned when the context is null
+static const json NULL_VALUE = nullptr;
+
+struct Renderer::PendingPartial {
+        /// Position of the partial output in the including template output
+        std::size_t offset;
+
+        /// Keeps the template alive while it's rendered
+        TemplatePtr partial;
+
+        unique_ptr<Renderer> renderer;
+
+        bool failed;
+
+        /// Statistics of the partial (if enabled)
+        RenderStats stats;
+};
+
+struct Renderer::AsyncLoad {
+        Renderer* renderer;
+        TemplatePtr view;
+        const json* context;
+        AsyncLoader* loader;
+        Callback done;
+
+        /// Files being read, with their read errors
+        vector<string> fileNames;
+        vector<string> errors;
+
+        /// Reads not completed yet
+        std::atomic<std::size_t> remaining;
+};
+
+struct Renderer::ProfileScope {
+        explicit ProfileScope(Renderer& renderer) :
+                        renderer_(renderer.profile_ != nullptr ? &renderer : nullptr),
+                        site_(nullptr), bytes_(0) {
+                if (renderer_ != nullptr) {
+                        // Productions start after the start delimiter
+                        site_ = &renderer.profileSite(renderer.currentToken_ - 1);
+                        bytes_ = renderer.rendered_.size();
+                        begin_ = std::chrono::steady_clock::now();
+                }
+        }
+
+        ~ProfileScope() {
+                if (renderer_ != nullptr) {
+                        ++site_->count;
+                        site_->time += std::chrono::steady_clock::now() - begin_;
+                        site_->bytes += renderer_->rendered_.size() - bytes_;
+                }
+        }
+
+        Renderer* renderer_;
+        ProfileSite* site_;
+        std::size_t bytes_;
+        std::chrono::steady_clock::time_point begin_;
+};
+
+#define IS_TOKEN(tokenKind) \
+        (tokens_->kind(currentToken_) == (tokenKind))
+
+#define IS_TOKEN_EMPTY() \
+        (currentToken_ == tokens_->size())
+
+#define CHECK_TOKEN_NOT_EMPTY() \
+        if (currentToken_ == tokens_->size()) { \
+                error("Unexpected end of file."); \
+                return; \
+        }
+
+#define CONSUME_TOKEN() \
+        ((stats_ != nullptr) ? ++stats_->tokens : 0), ++ currentToken_
+
+#define CHECK_TOKEN_IS(tokenKind) \
+        if ((currentToken_ == tokens_->size()) || !IS_TOKEN(tokenKind)) { \
+                error("Missing " + tokenKindText(tokenKind)); \
+                return; \
+        }
+
+#define CHECK_TOKEN_IS_NOT(tokenKind) \
+        if ((currentToken_ != tokens_->size()) && IS_TOKEN(tokenKind)) { \
+                error("Unexpected " + tokenKindText(tokenKind)); \
+                return; \
+        }
+
+// Ensure token is (txt).
+#define CHECK_TOKEN_IS_TEXT() \
+        CHECK_TOKEN_NOT_EMPTY(); \
+        if (!IS_TOKEN(TokenKind::Text)) { \
+                error("Unexpected " + tokenKindText(tokens_->kind(currentToken_))); \
+                return; \
+        }
+
+Renderer::Renderer(const Engine& engine) :
+        engine_(engine), escape_(engine.escapeFunction()),
+        tokens_(nullptr), currentToken_(0),
+        currentListCounter_(0), listDepth_(0),
+        parallelPartials_(engine.options().parallelPartials),
+        nonBlocking_(false), resumed_(false), stats_(nullptr), profile_(nullptr),
+        observer_(engine.options().observer.get()), metrics_(nullptr),
+        partialFailed_(false) {
+}
+
+Renderer::~Renderer() {
+}
+
+bool Renderer::render(const Template& view, const json& context) {
+        return renderContext(view, context, std::chrono::nanoseconds::zero());
+}
+
+bool Renderer::renderContext(const Template& view, const json& context,
+                             std::chrono::nanoseconds parseTime) {
+        error_.clear();
+        rendered_.clear();
+        clearPartials();
+        partialFailed_ = false;
+        std::chrono::steady_clock::time_point begin;
+        Allocations allocated = { 0, 0 };
+        if (stats_ != nullptr) {
+                stats_->reset();
+                stats_->parseContextTime = parseTime;
+                begin = std::chrono::steady_clock::now();
+                allocated = threadAllocations();
+        }
+
+        tokens_ = &view;
+        currentToken_ = 0;
+        currentListCounter_ = 0;
+        listDepth_ = 0;
+
+        // Reset stack: start from a stack containing the whole json
+        stack_.clear();
+        pushContext(&context);
+
+        if (profile_ != nullptr) {
+                frames_.clear();
+                enterFrame(viewName_);
+        }
+        if (observer_ != nullptr && !resumed_) {
+                observer_->renderBegin(view);
+        }
+
+        const bool result = run(&Renderer::produceMessage);
+        if (stats_ != nullptr) {
+                stats_->renderTime = std::chrono::steady_clock::now() - begin;
+                stats_->bytesEmitted = rendered_.size();
+                stats_->allocations += threadAllocations().count - allocated.count;
+                stats_->allocatedBytes += threadAllocations().bytes - allocated.bytes;
+        }
+        if (profile_ != nullptr) {
+                finishProfile();
+        }
+        // A suspended renderAsync() ends (and is counted) when it completes
+        if (observer_ != nullptr && misses_.empty()) {
+                if (!result) {
+                        observer_->error(error_);
+                }
+                observer_->renderEnd(view, result, rendered_.size());
+        }
+        if (metrics_ != nullptr && misses_.empty()) {
+                metrics_->add(metricsName_, *stats_, result ? RenderResult::Ok :
+                              partialFailed_ ? RenderResult::PartialError :
+                              RenderResult::TemplateError);
+        }
+        if (!result) {
+                return false;
+        }
+        return true;
+}
+
+bool Renderer::render(const Template& view, const string& context) {
+        std::chrono::steady_clock::time_point begin;
+        if (stats_ != nullptr) {
+                begin = std::chrono::steady_clock::now();
+        }
+        try {
+                data_ = json::parse(context);
+        } catch (const std::exception& err) {
+                rendered_.clear();
+                error_ = err.what();
+                if (observer_ != nullptr) {
+                        observer_->error(error_);
+                }
+                if (stats_ != nullptr) {
+                        stats_->reset();
+                        stats_->parseContextTime = std::chrono::steady_clock::now() - begin;
+                }
+                if (metrics_ != nullptr) {
+                        metrics_->add(metricsName_, *stats_, RenderResult::ContextError);
+                }
+                return false;
+        }
+        if (stats_ == nullptr) {
+                return render(view, data_);
+        }
+        return renderContext(view, data_, std::chrono::steady_clock::now() - begin);
+}
+
+bool Renderer::run(void (Renderer::*production)()) {
+        try {
+                (this->*production)();
+                joinPartials();
+        } catch (const RenderException& err) {
+                error_ = err.what();
+                // Partials started before the error are part of the output
+                // and their errors come first.
+                try {
+                        joinPartials();
+                } catch (const RenderException& partialError) {
+                        error_ = partialError.what();
+                }
+                return false;
+        } catch (...) {
+                abandonPartials();
+                throw;
+        }
+        return true;
+}
+
+void Renderer::joinPartials() {
+        if (pending_.empty()) {
+                return;
+        }
+        try {
+                partials_->wait();
+        } catch (...) {
+                pending_.clear();
+                throw;
+        }
+
+        string stitched;
+        std::size_t last = 0;
+        for (std::size_t i = 0; i < pending_.size(); ++i) {
+                const PendingPartial& pending = *pending_.at(i);
+                for (const string& fileName : pending.renderer->used_) {
+                        usePartial(fileName);
+                }
+                if (stats_ != nullptr) {
+                        stats_->merge(pending.stats);
+                }
+                stitched.append(rendered_, last, pending.offset - last);
+                stitched.append(pending.renderer->rendered_);
+                last = pending.offset;
+                if (pending.failed) {
+                        partialFailed_ = pending.renderer->partialFailed_;
+                        rendered_.swap(stitched);
+                        const string message = pending.renderer->error_;
+                        pending_.clear();
+                        error(message);
+                }
+        }
+        stitched.append(rendered_, last, string::npos);
+        rendered_.swap(stitched);
+        pending_.clear();
+}
+
+void Renderer::waitPartials() {
+        if (partials_ && !pending_.empty()) {
+                try {
+                        partials_->wait();
+                } catch (...) {
+                        // Reported by joinPartials() or already handling
+                        // an exception
+                }
+        }
+}
+
+void Renderer::abandonPartials() {
+        waitPartials();
+        pending_.clear();
+}
+
+void Renderer::renderAsync(const TemplatePtr& view, const json& context,
+                           AsyncLoader& loader, Callback done) {
+        loadErrors_.clear();
+        resumeAsync(view, context, loader, done);
+}
+
+void Renderer::resumeAsync(const TemplatePtr& view, const json& context,
+                           AsyncLoader& loader, const Callback& done) {
+        misses_.clear();
+        nonBlocking_ = true;
+        const bool parallelPartials = parallelPartials_;
+        parallelPartials_ = false;
+        bool result;
+        try {
+                result = render(*view, context);
+        } catch (...) {
+                nonBlocking_ = false;
+                resumed_ = false;
+                parallelPartials_ = parallelPartials;
+                throw;
+        }
+        nonBlocking_ = false;
+        resumed_ = false;
+        parallelPartials_ = parallelPartials;
+
+        if (misses_.empty()) {
+                done(result);
+                return;
+        }
+
+        // Suspend: the output is incomplete and will be rendered again when
+        // all the missing partials are cached. Errors found so far come
+        // after the first missing partial, so they may change too.
+        shared_ptr<AsyncLoad> load = std::make_shared<AsyncLoad>();
+        load->renderer = this;
+        load->view = view;
+        load->context = &context;
+        load->loader = &loader;
+        load->done = done;
+        load->fileNames.swap(misses_);
+        load->errors.resize(load->fileNames.size());
+        load->remaining = load->fileNames.size();
+        for (std::size_t i = 0; i < load->fileNames.size(); ++i) {
+                loader.read(load->fileNames.at(i), [load, i](const string& contents, const string& error) {
+                        if (error.empty()) {
+                                load->renderer->engine_.add(load->fileNames.at(i), contents);
+                        } else {
+                                load->errors.at(i) = error;
+                        }
+                        if (--load->remaining != 0) {
+                                return;
+                        }
+                        // Last read: resume the render on this thread
+                        Renderer& renderer = *load->renderer;
+                        for (std::size_t f = 0; f < load->fileNames.size(); ++f) {
+                                if (!load->errors.at(f).empty()) {
+                                        renderer.loadErrors_[load->fileNames.at(f)] = load->errors.at(f);
+                                }
+                        }
+                        renderer.resumed_ = true;
+                        renderer.resumeAsync(load->view, *load->context, *load->loader, load->done);
+                });
+        }
+}
+
+const string& Renderer::output() const {
+        return rendered_;
+}
+
+const string& Renderer::error() const {
+        return error_;
+}
+
+const vector<string>& Renderer::partials() const {
+        return used_;
+}
+
+void Renderer::setStats(RenderStats* stats) {
+        stats_ = (stats == nullptr && metrics_ != nullptr) ? &metricsStats_ : stats;
+}
+
+void Renderer::setProfile(Profile* profile, const string& viewName) {
+        profile_ = profile;
+        viewName_ = viewName;
+}
+
+void Renderer::setObserver(RenderObserver* observer) {
+        observer_ = observer;
+}
+
+void Renderer::setMetrics(Metrics* metrics, const string& viewName) {
+        const bool ownStats = (stats_ == nullptr || stats_ == &metricsStats_);
+        metrics_ = metrics;
+        metricsName_ = viewName;
+        if (ownStats) {
+                stats_ = (metrics != nullptr) ? &metricsStats_ : nullptr;
+        }
+}
+
+TemplatePtr Renderer::loadObserved(const string& fileName, const vector<string>& parameters) {
+        RenderStats load;
+        const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        const TemplatePtr partial = engine_.loadPartial(fileName, parameters, &load);
+        observer_->partialLoad(fileName, load.partialMisses == 0,
+                               std::chrono::steady_clock::now() - begin);
+        if (stats_ != nullptr) {
+                stats_->merge(load);
+        }
+        return partial;
+}
+
+/// FNV-1a hash of the kinds and the text of the tokens of a template.
+static std::uint64_t tokensHash(const Template& view) {
+        std::uint64_t hash = 14695981039346656037ULL;
+        const std::uint64_t prime = 1099511628211ULL;
+        for (Template::TokenIndex i = 0; i < view.size(); ++i) {
+                hash = (hash ^ static_cast<unsigned char>(view.kind(i))) * prime;
+                const char* data = view.data(i);
+                const std::size_t length = view.length(i);
+                for (std::size_t j = 0; j < length; ++j) {
+                        hash = (hash ^ static_cast<unsigned char>(data[j])) * prime;
+                }
+        }
+        return hash;
+}
+
+void Renderer::enterFrame(const string& file) {
+        ProfileFrame frame;
+        // ';' separates the frames of folded stacks
+        string name = file;
+        std::replace(name.begin(), name.end(), ';', ':');
+        frame.path = frames_.empty() ? name : frames_.back().path + ";" + name;
+        frame.file = file;
+        frame.sites = &profileFiles_[file];
+        ProfileSource& source = profileSources_[file];
+        if (source.id != tokens_->id()) {
+                // Sites are described on first use: keep the descriptions
+                // only if the template has the same tokens (another view
+                // with the default name is a different template)
+                const std::uint64_t hash = tokensHash(*tokens_);
+                if (source.id == 0 || source.hash != hash ||
+                                frame.sites->size() != tokens_->size()) {
+                        frame.sites->assign(tokens_->size(), ProfileSite());
+                }
+                source.id = tokens_->id();
+                source.hash = hash;
+        }
+        frame.begin = std::chrono::steady_clock::now();
+        frame.children = std::chrono::nanoseconds::zero();
+        frames_.push_back(frame);
+}
+
+std::chrono::nanoseconds Renderer::leaveFrame() {
+        const ProfileFrame& frame = frames_.back();
+        const std::chrono::nanoseconds time = std::chrono::steady_clock::now() - frame.begin;
+        profileStacks_[frame.path] += time - frame.children;
+        frames_.pop_back();
+        if (!frames_.empty()) {
+                frames_.back().children += time;
+        }
+        return time;
+}
+
+void Renderer::finishProfile() {
+        // Frames left open by an error end here
+        std::chrono::nanoseconds time = std::chrono::nanoseconds::zero();
+        while (!frames_.empty()) {
+                time = leaveFrame();
+        }
+        // A suspended renderAsync() pass is rendered again from scratch
+        if (!nonBlocking_ || misses_.empty()) {
+                profile_->add(profileFiles_, profileStacks_, time);
+        }
+        for (Profile::Files::iterator file = profileFiles_.begin(); file != profileFiles_.end(); ++file) {
+                for (ProfileSite& site : file->second) {
+                        site.count = 0;
+                        site.time = std::chrono::nanoseconds::zero();
+                        site.bytes = 0;
+                }
+        }
+        profileStacks_.clear();
+}
+
+ProfileSite& Renderer::profileSite(TokenIndex index) {
+        ProfileSite& site = (*frames_.back().sites)[index];
+        if (site.tag.empty()) {
+                const TokenKind kind = tokens_->kind(index);
+                const Template::Position position = tokens_->position(index);
+                site.file = frames_.back().file;
+                site.line = position.line;
+                site.column = position.column;
+                site.tag = tokenKindText(kind) + " ";
+                if (index + 1 < tokens_->size()) {
+                        site.tag += tokens_->text(index + 1) + " ";
+                }
+                site.tag += (kind == TokenKind::StartVariableUnescaped) ? "}}}" : "}}";
+        }
+        return site;
+}
+
+void Renderer::usePartial(const string& fileName) {
+        if (std::find(used_.begin(), used_.end(), fileName) != used_.end()) {
+                return;
+        }
+        if (spare_.empty()) {
+                used_.push_back(fileName);
+        } else {
+                used_.push_back(std::move(spare_.back()));
+                spare_.pop_back();
+                used_.back().assign(fileName);
+        }
+}
+
+void Renderer::clearPartials() {
+        for (string& fileName : used_) {
+                spare_.push_back(std::move(fileName));
+        }
+        used_.clear();
+}
+
+void Renderer::produceMessage() {
+        if (IS_TOKEN_EMPTY()) {
+                return;
+        }
+        if (stats_ != nullptr) {
+                ++stats_->tagsByKind[static_cast<std::size_t>(tokens_->kind(currentToken_))];
+        }
+        if (IS_TOKEN(TokenKind::StartVariable)) {
+                CONSUME_TOKEN();
+                produceVariable();
+                CONSUME_TOKEN();
+                produceMessage();
+
+                return;
+        }
+        if (IS_TOKEN(TokenKind::StartVariableUnescaped)) {
+                CONSUME_TOKEN();
+                produceVariableUnescaped();
+                CONSUME_TOKEN();
+                produceMessage();
+
+                return;
+        }
+        if (IS_TOKEN(TokenKind::StartComment)) {
+                CONSUME_TOKEN();
+                produceComment();
+                CONSUME_TOKEN();
+                produceMessage();
+
+                return;
+        }
+        if (IS_TOKEN(TokenKind::StartBeginSection) || IS_TOKEN(TokenKind::StartIf) ||
+            IS_TOKEN(TokenKind::StartUnless) || IS_TOKEN(TokenKind::StartExistsTest)) {
+                CONSUME_TOKEN();
+                produceSection();
+                CONSUME_TOKEN();
+                produceMessage();
+                return;
+        }
+        if (IS_TOKEN(TokenKind::StartEndSection)) {
+                //        if (stack_.size() == 1) {
+                //            error("Unexpected end of block '" + tokenKindText(TokenKind::StartEndSection) + "'");
+                //        }
+                // If we are in a block do not throw error.. simply return
+                return;
+        }
+        if (IS_TOKEN(TokenKind::StartPartial) || IS_TOKEN(TokenKind::StartTemplate)) {
+                CONSUME_TOKEN();
+                producePartial();
+                CONSUME_TOKEN();
+                produceMessage();
+                return;
+        }
+        if (IS_TOKEN(TokenKind::End)) {
+                error("Unexpected end of variable '" + tokenKindText(TokenKind::End) + "'");
+                return;
+        }
+
+        rendered_.append(tokens_->data(currentToken_), tokens_->length(currentToken_));
+        CONSUME_TOKEN();
+        produceMessage();
+}
+
+void Renderer::produceVariable()
+{
+        const ProfileScope scope(*this);
+
+        // Token must be (txt)
+        CHECK_TOKEN_IS_TEXT();
+
+        printVariable(true);
+
+        CONSUME_TOKEN();
+        CHECK_TOKEN_NOT_EMPTY();
+        CHECK_TOKEN_IS(TokenKind::End);
+}
+
+void Renderer::produceVariableUnescaped()
+{
+        const ProfileScope scope(*this);
+
+        // Token must be (txt)
+        CHECK_TOKEN_IS_TEXT();
+
+        printVariable(false);
+
+        CONSUME_TOKEN();
+        CHECK_TOKEN_NOT_EMPTY();
+        CHECK_TOKEN_IS(TokenKind::EndUnescaped);
+}
+
+void Renderer::printVariable(bool escape)
+{
+    const Template::Tag& tag = tokens_->tag(currentToken_);
+    if (!tag.error.empty()) {
+        error(tag.error);
+    }
+    const int decimals = tag.decimals;
+    const json* variable = searchVariableInContext(tag);
+
+    // Scalars are written straight into the output
+    if (variable == nullptr || variable->is_null()) {
+        // OK
+    } else if (variable->is_boolean()) {
+        if (variable->get<bool>()) {
+            rendered_.append("true");
+        }
+    } else if (variable->is_string()) {
+        const string& value = variable->get_ref<const string&>();
+        if (escape) {
+            escape_(rendered_, value.data(), value.size());
+            if (stats_ != nullptr) {
+                ++stats_->escapes;
+            }
+        } else {
+            rendered_.append(value);
+        }
+    } else if (variable->is_number_unsigned()) {
+        const json::number_unsigned_t value = variable->get<json::number_unsigned_t>();
+        if (decimals == NUMBER_FORMAT_DEFAULT) {
+            appendUnsigned(rendered_, value);
+        } else {
+            appendFixed(rendered_, static_cast<std::uint64_t>(value), decimals);
+        }
+    } else if (variable->is_number_integer()) {
+        const json::number_integer_t value = variable->get<json::number_integer_t>();
+        if (decimals == NUMBER_FORMAT_DEFAULT) {
+            appendInteger(rendered_, value);
+        } else {
+            appendFixed(rendered_, static_cast<std::int64_t>(value), decimals);
+        }
+    } else if (variable->is_number_float()) {
+        const json::number_float_t value = variable->get<json::number_float_t>();
+        if (decimals == NUMBER_FORMAT_DEFAULT) {
+            appendFloat(rendered_, value);
+        } else {
+            appendFixed(rendered_, value, decimals);
+        }
+    }
+    // else skip render invisible parts
+}
+
+void Renderer::produceComment() {
+        // Token must be (txt)
+        CHECK_TOKEN_IS_TEXT();
+
+        CONSUME_TOKEN();
+        CHECK_TOKEN_NOT_EMPTY();
+        CHECK_TOKEN_IS(TokenKind::End);
+}
+
+void Renderer::produceSection() {
+        const ProfileScope scope(*this);
+        const TokenIndex sectionStart = currentToken_ - 1;
+        bool useSection = (tokens_->kind(currentToken_ - 1) == TokenKind::StartBeginSection);
+        bool useUnless = (tokens_->kind(currentToken_ - 1) == TokenKind::StartUnless);
+        bool useExistsTest = (tokens_->kind(currentToken_ - 1) == TokenKind::StartExistsTest);
+
+        // Token must be (txt)
+        CHECK_TOKEN_IS_TEXT();
+
+        // Save var name
+        const Template::Tag& tag = tokens_->tag(currentToken_);
+        const string& variableName = tag.name;
+        if (!tag.error.empty()) {
+                error(tag.error);
+        }
+
+        const json* variable = searchVariableInContext(tag);
+        const bool variable_exists = (variable != nullptr);
+        // Special variables (Eg: @index) are overwritten by the next
+        // search: keep a copy.
+        json special;
+        if (variable == nullptr) {
+            variable = &NULL_VALUE;
+        } else if (variable == &special_) {
+            special = special_;
+            variable = &special;
+        }
+        // Partials started inside the section may use special: wait for
+        // them before it goes out of scope, even on error.
+        struct WaitPartials {
+                Renderer& renderer;
+                bool active;
+                ~WaitPartials() {
+                        if (active) {
+                                renderer.waitPartials();
+                        }
+                }
+        } waitPartials = { *this, variable == &special };
+
+        // Is variable malformed
+        bool isCorrectType = variable->is_null() || variable->is_boolean() ||
+                             variable->is_string() || variable->is_array() ||
+                             variable->is_object() || variable->is_number();
+        if (!isCorrectType) {
+                error("Variable '" + variableName + "' is malformed");
+                return;
+        }
+
+        CONSUME_TOKEN();
+        CHECK_TOKEN_NOT_EMPTY();
+        CHECK_TOKEN_IS(TokenKind::End);
+
+        const TokenKind sectionKind = tokens_->kind(sectionStart);
+        if (observer_ != nullptr) {
+                observer_->sectionEnter(sectionKind, variableName);
+        }
+        // Times the body is rendered (for the observer)
+        std::size_t iterations = 0;
+
+        CONSUME_TOKEN();
+        // The logic of section block {{# }}
+        // - [ a, b, c, .. ] ==> cycle
+        // - [], {}, "", false, null ==> hide
+        // - { something }, "something", true ==> view
+        // Section always changes context. EG:
+        //
+        // context = {
+        //   "var1": { "one": 1, "two": 2 },
+        //   "var2": "value2"
+        // }
+        //
+        // template =  {{# var1 }}{{ one }}{{/ var1 }}
+        //
+        // output = 1
+        //
+        if (useSection && variable->is_array() && variable->size() > 0) {
+                iterations = variable->size();
+                const TokenIndex savedPosition = currentToken_;
+                const std::size_t threshold = engine_.options().parallelSectionThreshold;
+                if (!nonBlocking_ && profile_ == nullptr && threshold > 0 &&
+                    variable->size() >= threshold) {
+                        produceSectionParallel(*variable);
+                } else {
+                        // Json iterators are not random access: count
+                        // the items instead of using std::distance()
+                        std::size_t counter = 0;
+                        ++listDepth_;
+                        for (json::const_iterator it = variable->begin(); it != variable->end(); ++it) {
+                                currentToken_ = savedPosition;
+                                currentListCounter_ = counter++;
+                                pushContext(&*it);
+                                produceMessage();
+                                stack_.pop_back();
+                        }
+                        --listDepth_;
+                }
+                // Reset to 0 after the main cycle
+                currentListCounter_ = 0;
+        } else {
+                // The hide variable is used for {{= }} and {{# }} logic
+                bool hide =
+                        (variable->is_array() && variable->size() == 0) ||
+                        (variable->is_object() && variable->size() == 0) ||
+                        (variable->is_string() && variable->get<string>().size() == 0) ||
+                        (variable->is_boolean() && !variable->get<bool>()) ||
+                        (variable->is_number() && variable->get<int>() == 0) ||
+                        (variable->is_null());
+
+                if (useExistsTest) {
+                        // The exist test {{0 }} uses a different logic:
+                        // If the key do not exists the section is not shown.
+                        hide = !variable_exists;
+                } else if (useUnless) {
+                        // The inverted section {{^ }} uses inverted logic
+                        hide = !hide;
+                }
+                if (hide) {
+                        // Jump to the end of the section: nothing inside
+                        // is evaluated, partials are not loaded.
+                        currentToken_ = tokens_->sectionEnd(sectionStart);
+                } else {
+                        iterations = 1;
+                        // The only difference from {{# }} and {{= }} {{^ }} {{? }}
+                        // is the fact that tag {{# }} changes context.
+                        if (useSection) {
+                                pushContext(variable);
+                        }
+                        produceMessage();
+                        if (useSection) {
+                                stack_.pop_back();
+                        }
+                }
+        }
+        if (variable == &special) {
+                joinPartials();
+        }
+
+        CHECK_TOKEN_IS(TokenKind::StartEndSection);
+
+        CONSUME_TOKEN();
+        CHECK_TOKEN_NOT_EMPTY();
+        const string& variableNameEnd = tokens_->text(currentToken_);
+        if (variableNameEnd != variableName) {
+                error("Expected '" + variableName + "' in closing block (found '" +
+                      variableNameEnd + "')");
+                return;
+        }
+
+        CONSUME_TOKEN();
+        CHECK_TOKEN_NOT_EMPTY();
+        CHECK_TOKEN_IS(TokenKind::End);
+        if (observer_ != nullptr) {
+                observer_->sectionExit(sectionKind, variableName, iterations);
+        }
+}
+
+void Renderer::produceSectionParallel(const json& array) {
+        const TokenIndex savedPosition = currentToken_;
+        ThreadPool& pool = *engine_.pool();
+        const std::size_t count = array.size();
+        const std::size_t chunks = std::min(count, static_cast<std::size_t>(pool.size()) * 4);
+
+        // Each chunk of items is rendered by a child renderer into its own
+        // buffer, starting from the same state of this renderer.
+        vector<unique_ptr<Renderer> > children(chunks);
+        // Not vector<bool>: its items cannot be written concurrently
+        vector<unsigned char> failed(chunks, 0);
+        vector<RenderStats> stats(stats_ != nullptr ? chunks : 0);
+        TaskGroup group(pool);
+        for (std::size_t c = 0; c < chunks; ++c) {
+                const std::size_t begin = c * count / chunks;
+                const std::size_t end = (c + 1) * count / chunks;
+                children.at(c).reset(new Renderer(engine_));
+                Renderer* child = children.at(c).get();
+                child->tokens_ = tokens_;
+                child->stack_ = stack_;
+                // Items are already rendered concurrently
+                child->parallelPartials_ = false;
+                child->observer_ = observer_;
+                if (stats_ != nullptr) {
+                        child->stats_ = &stats.at(c);
+                }
+                group.run([child, &array, &failed, c, begin, end, savedPosition]() {
+                        try {
+                                for (std::size_t i = begin; i < end; ++i) {
+                                        child->currentToken_ = savedPosition;
+                                        child->currentListCounter_ = i;
+                                        child->pushContext(&array[i]);
+                                        child->produceMessage();
+                                        child->stack_.pop_back();
+                                }
+                        } catch (const RenderException& err) {
+                                child->error_ = err.what();
+                                failed[c] = 1;
+                        }
+                });
+        }
+        group.wait();
+
+        // Stitch the outputs in order: the first error stops rendering, as
+        // if the items were rendered sequentially.
+        for (std::size_t c = 0; c < chunks; ++c) {
+                const Renderer& child = *children.at(c);
+                for (const string& fileName : child.used_) {
+                        usePartial(fileName);
+                }
+                if (stats_ != nullptr) {
+                        stats_->merge(stats.at(c));
+                }
+                rendered_.append(child.rendered_);
+                if (failed[c] != 0) {
+                        partialFailed_ = child.partialFailed_;
+                        error(child.error_);
+                }
+        }
+        currentToken_ = children.at(0)->currentToken_;
+}
+
+void Renderer::producePartial() {
+        const ProfileScope scope(*this);
+        bool useTemplate = (tokens_->kind(currentToken_ - 1) == TokenKind::StartTemplate);
+
+        // Token must be (txt)
+        CHECK_TOKEN_IS_TEXT();
+
+        // The tag is something like:
+        //   paragraph|title=SampleTitle|text=SampleText
+        // The first part is the partial file name (split at compile time).
+        const Template::Tag& tag = tokens_->tag(currentToken_);
+        const string& tagText = tokens_->text(currentToken_);
+        if (!tag.error.empty()) {
+                error(tag.error);
+        }
+
+        CONSUME_TOKEN();
+        CHECK_TOKEN_NOT_EMPTY();
+        CHECK_TOKEN_IS(TokenKind::End);
+
+        const string& fileToRead = useTemplate ? getTemplateNameFromContext(tag) : tag.name;
+        if (observer_ != nullptr) {
+                observer_->partialResolve(tagText, fileToRead);
+        }
+        usePartial(fileToRead);
+        const vector<string>& parameters = tag.parameters;
+        TemplatePtr partial;
+        if (nonBlocking_) {
+                partial = engine_.find(fileToRead, parameters);
+                if (stats_ != nullptr) {
+                        ++(partial ? stats_->partialHits : stats_->partialMisses);
+                }
+                if (observer_ != nullptr && partial) {
+                        observer_->partialLoad(fileToRead, true, std::chrono::nanoseconds::zero());
+                }
+                if (!partial) {
+                        const map<string, string>::const_iterator failed = loadErrors_.find(fileToRead);
+                        if (failed != loadErrors_.end()) {
+                                partialFailed_ = true;
+                                error(failed->second);
+                        }
+                        // Read it later, go on to find other missing partials
+                        if (std::find(misses_.begin(), misses_.end(), fileToRead) == misses_.end()) {
+                                misses_.push_back(fileToRead);
+                        }
+                        return;
+                }
+        } else {
+                try {
+                        partial = (observer_ == nullptr) ?
+                                engine_.loadPartial(fileToRead, parameters, stats_) :
+                                loadObserved(fileToRead, parameters);
+                } catch (const RenderException&) {
+                        partialFailed_ = true;
+                        throw;
+                }
+        }
+
+        if (parallelPartials_ && listDepth_ == 0 && profile_ == nullptr) {
+                // Render the partial into its own buffer while this template
+                // goes on: the output is inserted by joinPartials()
+                if (!partials_) {
+                        partials_.reset(new TaskGroup(*engine_.pool()));
+                }
+                pending_.push_back(unique_ptr<PendingPartial>(new PendingPartial()));
+                PendingPartial* pending = pending_.back().get();
+                pending->offset = rendered_.size();
+                pending->partial = partial;
+                pending->renderer.reset(new Renderer(engine_));
+                pending->failed = false;
+                Renderer* child = pending->renderer.get();
+                if (stats_ != nullptr) {
+                        child->stats_ = &pending->stats;
+                }
+                child->observer_ = observer_;
+                child->tokens_ = partial.get();
+                child->stack_ = stack_;
+                child->currentListCounter_ = currentListCounter_;
+                partials_->run([pending]() {
+                        pending->failed = !pending->renderer->run(&Renderer::producePartialBody);
+                });
+                return;
+        }
+
+        // Render the partial in place, then go back to the current template
+        const Template* const savedTokens = tokens_;
+        const TokenIndex savedPosition = currentToken_;
+        tokens_ = partial.get();
+        currentToken_ = 0;
+        if (profile_ != nullptr) {
+                string file = fileToRead;
+                for (const string& parameter : parameters) {
+                        file += '|';
+                        file += parameter;
+                }
+                enterFrame(file);
+        }
+        producePartialBody();
+        if (profile_ != nullptr) {
+                leaveFrame();
+        }
+        tokens_ = savedTokens;
+        currentToken_ = savedPosition;
+}
+
+void Renderer::producePartialBody() {
+        produceMessage();
+        CHECK_TOKEN_IS_NOT(TokenKind::StartEndSection);
+}
+
+void Renderer::error(const string& message) {
+        throw RenderException(message);
+}
+
+const json* Renderer::searchVariableInContext(const Template::Tag& tag) {
+        if (stats_ != nullptr) {
+                ++stats_->lookups;
+        }
+        if (tag.special == Template::Tag::Special::Index) {
+                special_ = currentListCounter_;
+                return &special_;
+        }
+        if (tag.special == Template::Tag::Special::First) {
+                special_ = (currentListCounter_ == 0);
+                return &special_;
+        }
+        // Get the current context
+        const json& top = *stack_.back();
+        if (top.is_null()) {
+                return &NULL_VALUE;
+        }
+        if (!tag.selectionError.empty()) {
+                error(tag.selectionError);
+        }
+        if (tag.selection == Template::Tag::Selection::Invalid) {
+                return notFound();
+        }
+
+        json::const_iterator it = top.find(tag.key);
+        if (it == top.end()) {
+                return notFound();
+        }
+        if (tag.selection == Template::Tag::Selection::None) {
+                return &*it;
+        }
+        if (it->is_array() && tag.index >= it->size()) {
+                return notFound();
+        }
+        return &(*it)[tag.index];
+}
+
+const json* Renderer::notFound() {
+        if (stats_ != nullptr) {
+                ++stats_->misses;
+        }
+        return nullptr;
+}
+
+void Renderer::pushContext(const json* context) {
+        stack_.push_back(context);
+        if (stats_ != nullptr && stack_.size() > stats_->maxStackDepth) {
+                stats_->maxStackDepth = stack_.size();
+        }
+}
+
+const string& Renderer::getTemplateNameFromContext(const Template::Tag& tag)
+{
+    const json* variable = searchVariableInContext(tag);
+
+    if (variable == nullptr || variable->is_null()) {
+        error("Missing template variable: " + tag.name);
+    } else if (!variable->is_string()) {
+        error("Wrong template variable type: " + tag.name + " must be a string");
+    }
+
+    return variable->get_ref<const string&>();
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,465 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-renderer.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Per-render state and template parser.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+#include "json.hpp"
+#include "mustache-escape.hpp"
+#include "mustache-template.hpp"
+#include "mustache-stats.hpp"
+#include "mustache-profile.hpp"
+#include "mustache-observer.hpp"
+#include "mustache-metrics.hpp"
+
+namespace mustache {
+
+class Engine;
+class TaskGroup;
+class AsyncLoader;
+
+/// Renders compiled templates.
+///
+/// A Renderer holds the state of a single render (output, context stack,
+/// current position) and reuses its buffers across renders.
+/// It's not thread-safe: use one Renderer per thread, all sharing the
+/// same Engine.
+///
+/// Tokens:
+///   sv  = start variable = {{
+///   svu = start variable unescaped= {{{
+///   sc  = start comment = {{!
+///   sb  = start begin of section = {{#
+///   se  = start end of section = {{/
+///   si  = start if = {{=
+///   s0  = start existing test = {{0
+///   su  = start unless = {{^
+///   sp  = start partial = {{>
+///   st  = start template = {{<
+///   ee  = end = }}
+///   eeu = end = }}}
+///   txt = (sequence of txt)
+///
+/// Grammar:
+///   MESSAGE            := VARIABLE MESSAGE | VARIABLE_UNESCAPED MESSAGE |
+///                         COMMENT MESSAGE | SECTION MESSAGE |
+///                         IF MESSAGE | UNLESS MESSAGE | EXISTS_TEST MESSAGE |
+///                         PARTIAL MESSAGE | txt MESSAGE | (empty)
+///   VARIABLE           := sv  txt ee
+///   VARIABLE_UNESCAPED := svu txt eeu
+///   COMMENT            := sc  txt ee
+///   IF                 := si  txt ee
+///   EXISTS_TEST        := s0  txt ee
+///   UNLESS             := sv  txt ee
+///   SECTION            := sb  txt ee MESSAGE se txt ee | sbi txt ee MESSAGE se txt ee
+///   PARTIAL            := sp  txt ee | st txt ee
+///
+class Renderer {
+  public:
+    // Public part
+
+    typedef Template::TokenIndex TokenIndex;
+
+    /// Called when an asynchronous render completes, with the result of
+    /// the render (true if no error occurred).
+    typedef std::function<void(bool)> Callback;
+
+    /// Construct a Renderer.
+    ///
+    /// @param engine
+    ///     The engine used to load partials. It must outlive the Renderer.
+    ///
+    explicit Renderer(const Engine& engine);
+
+    ~Renderer();
+
+    /// Renders a template.
+    ///
+    /// @param view
+    ///      The compiled template
+    /// @param context
+    ///      The context (the JSON object). It's not copied.
+    ///
+    /// @return
+    ///     true if no error occurred.
+    ///
+    bool render(const Template& view, const nlohmann::json& context);
+
+    /// Renders a template.
+    ///
+    /// @param view
+    ///      The compiled template
+    /// @param context
+    ///      The context (a std::string containing JSON data)
+    ///
+    /// @return
+    ///     true if no error occurred.
+    ///
+    bool render(const Template& view, const std::string& context);
+
+    /// Renders a template without blocking on file reads.
+    ///
+    /// Partials that are not cached are read by loader: meanwhile the
+    /// render is suspended and the calling thread is free. When the reads
+    /// complete the render resumes (from the thread completing the last
+    /// read): it starts again from the beginning, so each suspension reads
+    /// all the partials found missing until then. Output and errors are the
+    /// same of render(). Parallel features are not used.
+    ///
+    /// @param view
+    ///      The compiled template.
+    /// @param context
+    ///      The context (the JSON object). It must live until done is
+    ///      called, like the Renderer.
+    /// @param loader
+    ///      Reads the partials. It must live until done is called.
+    /// @param done
+    ///      Called once when the render completes (it may be called before
+    ///      renderAsync() returns). output() and error() hold the result.
+    ///
+    void renderAsync(const TemplatePtr& view, const nlohmann::json& context,
+                     AsyncLoader& loader, Callback done);
+
+    /// The output of the last render. On error it contains the output
+    /// produced until the error occurred.
+    const std::string& output() const;
+
+    /// Returns error message of the last render (if any) or a blank
+    /// std::string if no error occured.
+    const std::string& error() const;
+
+    /// File names of the partials used by the last render (without
+    /// duplicates), dynamic templates {{< name }} included. Partials whose
+    /// load failed are included too.
+    const std::vector<std::string>& partials() const;
+
+    /// Enables statistics: each following render resets stats and fills
+    /// it (renderAsync() fills it again every time it resumes).
+    /// Statistics are disabled by default and cost (almost) nothing.
+    ///
+    /// @param stats
+    ///     The statistics to fill, or nullptr to disable them. It must
+    ///     outlive the renders.
+    ///
+    void setStats(RenderStats* stats);
+
+    /// Enables profiling: each following render adds the time and the
+    /// output bytes of each tag to profile. Partials and sections are
+    /// rendered sequentially meanwhile.
+    ///
+    /// @param profile
+    ///     The profile, or nullptr to disable profiling. It must outlive
+    ///     the renders.
+    /// @param viewName
+    ///     Name of the views rendered in the profile (Eg: their file
+    ///     name).
+    ///
+    void setProfile(Profile* profile, const std::string& viewName = "(view)");
+
+    /// Sets the observer of the following renders (by default the one of
+    /// the engine options, if any).
+    ///
+    /// @param observer
+    ///     The observer, or nullptr to disable events. It must outlive the
+    ///     renders.
+    ///
+    void setObserver(RenderObserver* observer);
+
+    /// Adds each following render to metrics, with its result and the
+    /// statistics of setStats() (or statistics of its own, if disabled).
+    ///
+    /// @param metrics
+    ///     The metrics, or nullptr to disable them. It must outlive the
+    ///     renders.
+    /// @param viewName
+    ///     Name of the views rendered in the metrics.
+    ///
+    void setMetrics(Metrics* metrics, const std::string& viewName = "(view)");
+
+  private:
+    // Private part
+
+    const Engine& engine_;
+
+    /// Escapes variables printed with {{ var }}
+    EscapeFunction escape_;
+
+    /// The template being rendered (it changes inside partials)
+    const Template* tokens_;
+
+    TokenIndex currentToken_;
+
+    std::size_t currentListCounter_;
+
+    /// Array sections being iterated: partials inside them are rendered in
+    /// place even with parallelPartials_ (a task for each item costs more
+    /// than it saves)
+    std::size_t listDepth_;
+
+    /// Used to manage sections.
+    /// When a block {{# var }} ... {{/ var }} is found the parser should
+    /// iterate inside it.
+    std::vector<const nlohmann::json*> stack_;
+
+    /// Holds the value of special variables (Eg: @index)
+    nlohmann::json special_;
+
+    /// Holds the context when it's given as a string
+    nlohmann::json data_;
+
+    /// Stores render result
+    std::string rendered_;
+
+    /// Stores error message
+    std::string error_;
+
+    /// Partials used by the render (see partials())
+    std::vector<std::string> used_;
+
+    /// Strings of used_ of the previous render: their buffers are reused
+    std::vector<std::string> spare_;
+
+    /// Partials are rendered concurrently (see EngineOptions)
+    bool parallelPartials_;
+
+    /// A partial being rendered concurrently: its output goes at offset of
+    /// rendered_.
+    struct PendingPartial;
+
+    /// Partials being rendered concurrently, in document order
+    std::vector<std::unique_ptr<PendingPartial>> pending_;
+
+    /// Tasks rendering pending_ (declared after it: it must be destroyed,
+    /// so waited for, first)
+    std::unique_ptr<TaskGroup> partials_;
+
+    /// Partials must not be read from files: missing ones are added to
+    /// misses_ and rendered as empty (see renderAsync()).
+    bool nonBlocking_;
+
+    /// Partials not cached during a non-blocking render
+    std::vector<std::string> misses_;
+
+    /// The render is a renderAsync() resumed after a suspension
+    bool resumed_;
+
+    /// Read errors of partials loaded by renderAsync(), by file name
+    std::map<std::string, std::string> loadErrors_;
+
+    /// Statistics of the render (nullptr if disabled)
+    RenderStats* stats_;
+
+    /// See setProfile() (nullptr if disabled)
+    Profile* profile_;
+
+    /// See setProfile()
+    std::string viewName_;
+
+    /// Measures of the render (descriptions of the sites are kept)
+    Profile::Files profileFiles_;
+    Profile::Stacks profileStacks_;
+
+    /// The template described by the sites of a file.
+    struct ProfileSource {
+        /// See Template::id() (0 for none)
+        std::uint64_t id;
+
+        /// Hash of the tokens: templates compiled again from the same
+        /// text keep the descriptions
+        std::uint64_t hash;
+    };
+
+    /// Templates described by profileFiles_, by file
+    std::map<std::string, ProfileSource> profileSources_;
+
+    /// A template being profiled: the view or a partial.
+    struct ProfileFrame {
+        /// Stack of partials (Eg: "page;layout;user")
+        std::string path;
+
+        /// File name
+        std::string file;
+
+        Profile::Sites* sites;
+
+        std::chrono::steady_clock::time_point begin;
+
+        /// Time of the nested partials
+        std::chrono::nanoseconds children;
+    };
+
+    /// Templates being profiled, innermost last
+    std::vector<ProfileFrame> frames_;
+
+    /// Measures a tag while it's rendered.
+    struct ProfileScope;
+
+    /// See setObserver() (nullptr if disabled)
+    RenderObserver* observer_;
+
+    /// See setMetrics() (nullptr if disabled)
+    Metrics* metrics_;
+    std::string metricsName_;
+
+    /// stats_ when metrics are enabled and setStats() is not
+    RenderStats metricsStats_;
+
+    /// A partial of the render could not be loaded (for the metrics)
+    bool partialFailed_;
+
+    /// Reads of a suspended renderAsync()
+    struct AsyncLoad;
+
+    /// Renders in non-blocking mode, then completes or suspends the render.
+    void resumeAsync(const TemplatePtr& view, const nlohmann::json& context,
+                     AsyncLoader& loader, const Callback& done);
+
+    /// Runs a production, then waits for the partials it started.
+    ///
+    /// @return
+    ///     false if an error occurred (error_ holds the message).
+    ///
+    bool run(void (Renderer::*production)());
+
+    /// Renders view with context: parseTime is the time spent parsing
+    /// the context, for the statistics.
+    bool renderContext(const Template& view, const nlohmann::json& context,
+                       std::chrono::nanoseconds parseTime);
+
+    /// Waits for the pending partials and inserts their output.
+    ///
+    /// @throws RenderException
+    ///     The error of the first failed partial. The output stops there.
+    ///
+    void joinPartials();
+
+    /// Waits for the pending partials (their output is not inserted yet).
+    void waitPartials();
+
+    /// Waits for the pending partials and drops them.
+    void abandonPartials();
+
+    // Productions
+    void produceMessage();
+    void produceVariable();
+    void produceVariableUnescaped();
+    void produceComment();
+    void produceSection();
+
+    /// Renders the items of a big array section concurrently.
+    /// The current token must be the first one of the section body.
+    void produceSectionParallel(const nlohmann::json& array);
+    void producePartial();
+
+    /// Renders the body of a partial (the current template).
+    void producePartialBody();
+
+    /// Loads a partial notifying the observer.
+    TemplatePtr loadObserved(const std::string& fileName,
+                             const std::vector<std::string>& parameters);
+
+    /// Adds fileName to the partials used (if not there yet).
+    void usePartial(const std::string& fileName);
+
+    /// Empties the partials used keeping their strings for the next render.
+    void clearPartials();
+
+    void printVariable(bool escape);
+
+    /// Throws an exception and stops rendering.
+    [[noreturn]] void error(const std::string& message);
+
+    /// Variable get in the current context.
+    /// Missing variables are common (Eg: optional fields): they are not
+    /// errors, so no exception is thrown for them.
+    ///
+    /// @param tag
+    ///     The tag to search in the current context, already decomposed
+    ///     in key and array selection by the Template.
+    ///
+    /// @returns
+    ///     The value of the corresponding key, or nullptr if the key is not
+    ///     found (or its index is out of bounds). The pointer is valid until
+    ///     the context stack changes or the next search.
+    ///
+    /// @throws RenderException
+    ///     If the array selection is malformed (Eg: "items[").
+    ///
+    const nlohmann::json* searchVariableInContext(const Template::Tag& tag);
+
+    /// Starts profiling the current template (tokens_).
+    void enterFrame(const std::string& file);
+
+    /// Stops profiling the innermost template.
+    ///
+    /// @return
+    ///     The time spent in the template.
+    ///
+    std::chrono::nanoseconds leaveFrame();
+
+    /// Closes the frames left, adds the measures of the render to profile_
+    /// and resets them.
+    void finishProfile();
+
+    /// The site of the tag started at index in the innermost template.
+    ProfileSite& profileSite(TokenIndex index);
+
+    /// Result of a search that did not find the variable (counted as a
+    /// miss).
+    const nlohmann::json* notFound();
+
+    /// Pushes a context on the stack (tracking its maximum depth).
+    void pushContext(const nlohmann::json* context);
+
+    /// Name of the template selected by a dynamic template tag {{< name }}.
+    /// The reference points into the context.
+    const std::string& getTemplateNameFromContext(const Template::Tag& tag);
+
+    // Disallow default constructor, copy constructor and assign operator
+    Renderer();
+    Renderer(const Renderer&);
+    void operator=(const Renderer&);
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
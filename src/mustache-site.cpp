@@ -0,0 +1,283 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-site.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Incremental static site builds.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-site.hpp"
+#include "./mustache-batch-renderer.hpp"
+#include "./mustache-engine.hpp"
+#include "./mustache-exception.hpp"
+#include "./mustache-renderer.hpp"
+#include "./mustache-thread-pool.hpp"
+
+using json = nlohmann::json;
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <map>
+using std::map;
+#include <mutex>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+
+// getpid
+#include <unistd.h>
+// stat, mkdir
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace mustache {
+
+static const int STATE_VERSION = 1;
+
+/// Hash of the contents of a file (64 bit FNV-1a, hexadecimal).
+static string contentHash(const char* data, std::size_t size) {
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    static const char hex[] = "0123456789abcdef";
+    string result(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        result[i] = hex[hash & 0x0F];
+        hash >>= 4;
+    }
+    return result;
+}
+
+/// Reads and hashes each input file once per build.
+class SiteBuilder::Hashes {
+  public:
+    explicit Hashes(const TemplateSource& source) : source_(source) {
+    }
+
+    /// Hash of a file ("name.extension"), empty if it cannot be read.
+    string get(const string& fileName, const string& extension) {
+        const string key = fileName + "." + extension;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            map<string, string>::const_iterator found = hashes_.find(key);
+            if (found != hashes_.end()) {
+                return found->second;
+            }
+        }
+        // Files are hashed without holding the lock (a file may be hashed
+        // twice by concurrent pages: the result is the same)
+        TemplateSource::Contents contents;
+        const string hash = source_.read(fileName, extension, contents)
+                ? contentHash(contents.data, contents.size) : string();
+        std::lock_guard<std::mutex> lock(mutex_);
+        hashes_[key] = hash;
+        return hash;
+    }
+
+  private:
+    const TemplateSource& source_;
+    std::mutex mutex_;
+    map<string, string> hashes_;
+};
+
+/// Splits "name.extension" (the extension has no dots).
+static void splitKey(const string& key, string& fileName, string& extension) {
+    const string::size_type dot = key.rfind('.');
+    fileName = key.substr(0, dot);
+    extension = (dot == string::npos) ? string() : key.substr(dot + 1);
+}
+
+static bool fileExists(const string& path) {
+    struct stat info;
+    return ::stat(path.c_str(), &info) == 0;
+}
+
+/// Creates the directories containing path.
+static void createParents(const string& path) {
+    for (string::size_type slash = path.find('/', 1); slash != string::npos;
+         slash = path.find('/', slash + 1)) {
+        ::mkdir(path.substr(0, slash).c_str(), 0777);
+    }
+}
+
+SiteBuilder::SiteBuilder(const Engine& engine, const string& statePath) :
+        engine_(engine), statePath_(statePath) {
+}
+
+SiteBuildResult SiteBuilder::build(const vector<SitePage>& pages, unsigned threads) const {
+    ThreadPool pool(threads);
+    return build(pages, pool);
+}
+
+SiteBuildResult SiteBuilder::build(const vector<SitePage>& pages, ThreadPool& pool) const {
+    // Dependencies recorded by the last build (a missing or invalid state
+    // file just means everything is rebuilt)
+    json previous = json::object();
+    {
+        std::ifstream in(statePath_.c_str(), std::ios::in | std::ios::binary);
+        if (in) {
+            try {
+                json state = json::parse(in);
+                if (state.value("version", 0) == STATE_VERSION && state["pages"].is_object()) {
+                    previous = state["pages"];
+                }
+            } catch (const std::exception&) {
+                // Rebuild everything
+            }
+        }
+    }
+
+    const std::size_t count = pages.size();
+    const string& extension = engine_.partialExtension();
+    Hashes hashes(engine_.source());
+    vector<json> records(count);
+    vector<unsigned char> dirty(count, 0);
+    vector<string> errors(count);
+
+    // Find the pages whose inputs changed
+    const json& last = previous;
+    {
+        TaskGroup group(pool);
+        for (std::size_t i = 0; i < count; ++i) {
+            group.run([&pages, &last, &hashes, &records, &dirty, i]() {
+                const SitePage& page = pages[i];
+                const json::const_iterator found = last.find(page.output);
+                if (found == last.end() || !found->is_object() ||
+                    found->value("view", "") != page.view ||
+                    found->value("context", "") != page.context) {
+                    dirty[i] = 1;
+                    return;
+                }
+                const json::const_iterator inputs = found->find("inputs");
+                if (inputs == found->end() || !inputs->is_object() || !fileExists(page.output)) {
+                    dirty[i] = 1;
+                    return;
+                }
+                for (json::const_iterator input = inputs->begin(); input != inputs->end(); ++input) {
+                    string fileName;
+                    string fileExtension;
+                    splitKey(input.key(), fileName, fileExtension);
+                    if (!input->is_string() || hashes.get(fileName, fileExtension) != input->get<string>()) {
+                        dirty[i] = 1;
+                        return;
+                    }
+                }
+                records[i] = *found;
+            });
+        }
+        group.wait();
+    }
+
+    // Render them: each worker reuses its own renderer
+    {
+        BatchRenderer batch(engine_, pool);
+        TaskGroup group(pool);
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!dirty[i]) {
+                continue;
+            }
+            group.run([this, &pages, &hashes, &records, &errors, &batch, &extension, i]() {
+                const BatchRenderer::Lease lease(batch);
+                Renderer& renderer = lease.renderer();
+
+                const SitePage& page = pages[i];
+                try {
+                    const TemplatePtr view = engine_.load(page.view);
+                    if (!renderer.render(*view, engine_.fileRead(page.context, "json"))) {
+                        errors[i] = renderer.error();
+                        return;
+                    }
+                } catch (const RenderException& e) {
+                    errors[i] = e.what();
+                    return;
+                }
+
+                createParents(page.output);
+                std::ofstream out(page.output.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+                const string& output = renderer.output();
+                if (!out.write(output.data(), output.size())) {
+                    errors[i] = "Cannot write file: " + page.output;
+                    return;
+                }
+
+                json inputs = json::object();
+                inputs[page.view + "." + extension] = hashes.get(page.view, extension);
+                inputs[page.context + ".json"] = hashes.get(page.context, "json");
+                for (const string& partial : renderer.partials()) {
+                    inputs[partial + "." + extension] = hashes.get(partial, extension);
+                }
+                records[i] = { { "view", page.view }, { "context", page.context }, { "inputs", inputs } };
+            });
+        }
+        group.wait();
+    }
+
+    SiteBuildResult result;
+    result.rendered = 0;
+    result.skipped = 0;
+    json state = { { "version", STATE_VERSION }, { "pages", json::object() } };
+    json& recorded = state["pages"];
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!errors[i].empty()) {
+            result.errors.push_back(std::make_pair(pages[i].output, errors[i]));
+            continue;
+        }
+        if (dirty[i]) {
+            ++result.rendered;
+        } else {
+            ++result.skipped;
+        }
+        recorded[pages[i].output] = records[i];
+    }
+
+    const string temporary = statePath_ + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(temporary.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        out << state.dump(1) << '\n';
+        if (!out) {
+            std::remove(temporary.c_str());
+            throw RenderException("Cannot write file: " + statePath_);
+        }
+    }
+    if (std::rename(temporary.c_str(), statePath_.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw RenderException("Cannot write file: " + statePath_);
+    }
+
+    return result;
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-site.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Incremental static site builds.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+namespace mustache {
+
+class Engine;
+class ThreadPool;
+
+/// A page of a static site: a template rendered with a JSON file.
+struct SitePage {
+    /// Output file path (parent directories are created).
+    std::string output;
+
+    /// Template file name (relative to base path, without extension).
+    std::string view;
+
+    /// Context file name (relative to base path, without the "json"
+    /// extension).
+    std::string context;
+};
+
+/// Result of SiteBuilder::build().
+struct SiteBuildResult {
+    /// Pages rendered (because their inputs changed).
+    std::size_t rendered;
+
+    /// Pages up to date.
+    std::size_t skipped;
+
+    /// Pages that failed: output path and error. They are rendered again
+    /// by the next build.
+    std::vector<std::pair<std::string, std::string> > errors;
+};
+
+/// Builds static sites incrementally.
+///
+/// For each output the builder records the files it depends on (template,
+/// partials, dynamic templates {{< name }} and context) with a hash of
+/// their contents. A build renders only the pages whose inputs changed
+/// since the last build (or whose output is missing), in parallel.
+///
+/// Files are read through the engine source. Templates cached by the
+/// engine are not reloaded: use a new Engine for each build (or keep it up
+/// to date with a TemplateWatcher).
+///
+class SiteBuilder {
+  public:
+    // Public part
+
+    /// Construct a builder.
+    ///
+    /// @param engine
+    ///     Engine used to load and render templates.
+    /// @param statePath
+    ///     File holding the dependencies recorded by the last build (it's
+    ///     created if it does not exist).
+    ///
+    SiteBuilder(const Engine& engine, const std::string& statePath);
+
+    /// Builds the pages that changed and saves the dependencies.
+    /// Pages built before but not in pages are forgotten (their outputs
+    /// are not removed).
+    ///
+    /// @param pages
+    ///     All the pages of the site.
+    /// @param threads
+    ///     Number of threads (0 means one per hardware thread).
+    ///
+    /// @throws RenderException
+    ///     If the state file cannot be written.
+    ///
+    SiteBuildResult build(const std::vector<SitePage>& pages, unsigned threads = 0) const;
+
+    /// Builds the pages using an existing pool. See build() above.
+    SiteBuildResult build(const std::vector<SitePage>& pages, ThreadPool& pool) const;
+
+  private:
+    // Private part
+
+    const Engine& engine_;
+
+    const std::string statePath_;
+
+    /// Hashes of the input files read during a build
+    class Hashes;
+
+    // Disallow copy constructor and assign operator
+    SiteBuilder(const SiteBuilder&);
+    void operator=(const SiteBuilder&);
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,268 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-source.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Template sources (directory, memory, embedded).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-source.hpp"
+#include "./mustache-mapped-file.hpp"
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <memory>
+using std::shared_ptr;
+// std::atomic_load/atomic_store of the index
+#include <atomic>
+#include <algorithm>
+#include <fstream>
+
+#include <sys/stat.h>
+#include <dirent.h>
+
+namespace mustache {
+
+TemplateSource::~TemplateSource() {
+}
+
+string TemplateSource::describe(const string& fileName, const string& extension) const {
+    return fileName + "." + extension;
+}
+
+vector<string> TemplateSource::list(const string&) const {
+    return vector<string>();
+}
+
+vector<string> TemplateSource::directories() const {
+    return vector<string>();
+}
+
+void TemplateSource::refresh() const {
+}
+
+/// Appends the names of the files with an extension found in basePath + path
+/// (all the files if suffix is empty, extension included).
+static void listDirectory(const string& basePath, const string& path,
+                          const string& suffix, vector<string>& fileNames) {
+    DIR* dir = ::opendir((basePath + path).c_str());
+    if (!dir) {
+        return;
+    }
+    while (const struct dirent* entry = ::readdir(dir)) {
+        const string name = entry->d_name;
+        if (name.empty() || name[0] == '.') {
+            continue;
+        }
+        struct stat info;
+        if (::stat((basePath + path + name).c_str(), &info) != 0) {
+            continue;
+        }
+        if (S_ISDIR(info.st_mode)) {
+            listDirectory(basePath, path + name + "/", suffix, fileNames);
+        } else if (S_ISREG(info.st_mode) && name.size() > suffix.size() &&
+                   name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            fileNames.push_back(path + name.substr(0, name.size() - suffix.size()));
+        }
+    }
+    ::closedir(dir);
+}
+
+/// Names of the keys ending with "." + extension, without it.
+template <class Map>
+static vector<string> listKeys(const Map& files, const string& extension) {
+    const string suffix = "." + extension;
+    vector<string> fileNames;
+    for (typename Map::const_iterator it = files.begin(); it != files.end(); ++it) {
+        const string& name = it->first;
+        if (name.size() > suffix.size() &&
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            fileNames.push_back(name.substr(0, name.size() - suffix.size()));
+        }
+    }
+    std::sort(fileNames.begin(), fileNames.end());
+    return fileNames;
+}
+
+DirectorySource::DirectorySource(const string& basePath, bool mapFiles) :
+        basePath_(basePath), mapFiles_(mapFiles) {
+}
+
+bool DirectorySource::read(const string& fileName, const string& extension,
+                           Contents& contents) const {
+    const string realFileName = describe(fileName, extension);
+    if (mapFiles_) {
+        const MappedFilePtr file = MappedFile::open(realFileName);
+        if (!file) {
+            return false;
+        }
+        contents.data = file->data();
+        contents.size = file->size();
+        contents.storage = file;
+        return true;
+    }
+
+    std::ifstream in(realFileName.c_str(), std::ios::in | std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    const shared_ptr<string> buffer = std::make_shared<string>();
+    in.seekg(0, std::ios::end);
+    buffer->resize(in.tellg());
+    in.seekg(0, std::ios::beg);
+    in.read(&(*buffer)[0], buffer->size());
+    contents.data = buffer->data();
+    contents.size = buffer->size();
+    contents.storage = buffer;
+    return true;
+}
+
+string DirectorySource::describe(const string& fileName, const string& extension) const {
+    return basePath_ + fileName + "." + extension;
+}
+
+vector<string> DirectorySource::list(const string& extension) const {
+    vector<string> fileNames;
+    listDirectory(basePath_, "", "." + extension, fileNames);
+    std::sort(fileNames.begin(), fileNames.end());
+    return fileNames;
+}
+
+vector<string> DirectorySource::directories() const {
+    return vector<string>(1, basePath_);
+}
+
+SearchPathSource::SearchPathSource(const vector<string>& roots, bool mapFiles) :
+        roots_(roots) {
+    for (const string& root : roots_) {
+        directories_.push_back(DirectorySource(root, mapFiles));
+    }
+    refresh();
+}
+
+void SearchPathSource::refresh() const {
+    const shared_ptr<Index> index = std::make_shared<Index>();
+    for (std::size_t i = 0; i < roots_.size(); ++i) {
+        vector<string> fileNames;
+        listDirectory(roots_[i], "", "", fileNames);
+        for (const string& fileName : fileNames) {
+            // Files of the first directories win
+            index->insert(Index::value_type(fileName, i));
+        }
+    }
+    std::atomic_store(&index_, shared_ptr<const Index>(index));
+}
+
+const vector<string>& SearchPathSource::roots() const {
+    return roots_;
+}
+
+bool SearchPathSource::read(const string& fileName, const string& extension,
+                            Contents& contents) const {
+    const shared_ptr<const Index> index = std::atomic_load(&index_);
+    const Index::const_iterator found = index->find(fileName + "." + extension);
+    if (found == index->end()) {
+        return false;
+    }
+    return directories_[found->second].read(fileName, extension, contents);
+}
+
+string SearchPathSource::describe(const string& fileName, const string& extension) const {
+    const shared_ptr<const Index> index = std::atomic_load(&index_);
+    const Index::const_iterator found = index->find(fileName + "." + extension);
+    if (found != index->end()) {
+        return directories_[found->second].describe(fileName, extension);
+    }
+    string searched;
+    for (const string& root : roots_) {
+        searched.append(searched.empty() ? "" : ", ").append(root);
+    }
+    return fileName + "." + extension + " (searched in " + searched + ")";
+}
+
+vector<string> SearchPathSource::list(const string& extension) const {
+    return listKeys(*std::atomic_load(&index_), extension);
+}
+
+vector<string> SearchPathSource::directories() const {
+    return roots_;
+}
+
+MemorySource::MemorySource(const Files& files) {
+    for (Files::const_iterator it = files.begin(); it != files.end(); ++it) {
+        files_[it->first] = std::make_shared<const string>(it->second);
+    }
+}
+
+bool MemorySource::read(const string& fileName, const string& extension,
+                        Contents& contents) const {
+    std::map<string, shared_ptr<const string> >::const_iterator it =
+        files_.find(fileName + "." + extension);
+    if (it == files_.end()) {
+        return false;
+    }
+    contents.data = it->second->data();
+    contents.size = it->second->size();
+    contents.storage = it->second;
+    return true;
+}
+
+vector<string> MemorySource::list(const string& extension) const {
+    return listKeys(files_, extension);
+}
+
+EmbeddedSource::EmbeddedSource(const EmbeddedFile* files, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        files_[files[i].name] = &files[i];
+    }
+}
+
+bool EmbeddedSource::read(const string& fileName, const string& extension,
+                          Contents& contents) const {
+    std::map<string, const EmbeddedFile*>::const_iterator it =
+        files_.find(fileName + "." + extension);
+    if (it == files_.end()) {
+        return false;
+    }
+    contents.data = it->second->data;
+    contents.size = it->second->size;
+    contents.storage.reset();
+    return true;
+}
+
+vector<string> EmbeddedSource::list(const string& extension) const {
+    return listKeys(files_, extension);
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
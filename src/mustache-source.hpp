@@ -0,0 +1,276 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-source.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Template sources (directory, memory, embedded).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <cstddef>
+
+namespace mustache {
+
+/// Where template files (and other files, Eg: JSON contexts) come from.
+///
+/// The engine reads every file through its source: templates, partials and
+/// the files read by Engine::fileRead(). Sources must be thread-safe.
+///
+class TemplateSource {
+  public:
+    // Public part
+
+    /// Contents of a file.
+    struct Contents {
+        const char* data;
+        std::size_t size;
+
+        /// Keeps data alive (nullptr if data is never released, Eg: static
+        /// data). Compiled templates keep it, so data is not copied.
+        std::shared_ptr<const void> storage;
+    };
+
+    virtual ~TemplateSource();
+
+    /// Reads a file.
+    ///
+    /// @param fileName
+    ///     File name without extension (Eg: "partials/user").
+    /// @param extension
+    ///     File extension (Eg: "mustache").
+    /// @param contents
+    ///     Filled with the contents of the file.
+    ///
+    /// @return
+    ///     false if the file does not exist.
+    ///
+    virtual bool read(const std::string& fileName, const std::string& extension,
+                      Contents& contents) const = 0;
+
+    /// Name of a file in error messages (Eg: its path).
+    virtual std::string describe(const std::string& fileName,
+                                 const std::string& extension) const;
+
+    /// Lists the files with an extension (Eg: to compile all the templates
+    /// in advance, see Engine::warmUp()).
+    ///
+    /// @param extension
+    ///     File extension (Eg: "mustache").
+    ///
+    /// @return
+    ///     Sorted file names without extension (empty if the source cannot
+    ///     list its files).
+    ///
+    virtual std::vector<std::string> list(const std::string& extension) const;
+
+    /// Directories the files are read from, in search order (Eg: to watch
+    /// them, see TemplateWatcher).
+    ///
+    /// @return
+    ///     Paths prefixed to file names (empty if the files do not come
+    ///     from directories).
+    ///
+    virtual std::vector<std::string> directories() const;
+
+    /// Called when files are added to or removed from directories() (Eg:
+    /// by TemplateWatcher), for sources that index their files. Does
+    /// nothing by default.
+    virtual void refresh() const;
+};
+
+typedef std::shared_ptr<const TemplateSource> TemplateSourcePtr;
+
+/// Files in a directory (the default source).
+class DirectorySource : public TemplateSource {
+  public:
+    // Public part
+
+    /// Construct a source.
+    ///
+    /// @param basePath
+    ///     The directory (prefixed to file names as it is, Eg: "./views/").
+    /// @param mapFiles
+    ///     Map files in memory instead of reading them.
+    ///
+    explicit DirectorySource(const std::string& basePath, bool mapFiles = false);
+
+    bool read(const std::string& fileName, const std::string& extension,
+              Contents& contents) const override;
+
+    /// The file path.
+    std::string describe(const std::string& fileName,
+                         const std::string& extension) const override;
+
+    /// Files in base path and its subdirectories (hidden ones excluded).
+    std::vector<std::string> list(const std::string& extension) const override;
+
+    /// The base path.
+    std::vector<std::string> directories() const override;
+
+  private:
+    // Private part
+
+    const std::string basePath_;
+    const bool mapFiles_;
+};
+
+/// Files in an ordered list of directories (Eg: tenant overrides, then a
+/// theme, then the base templates): a file is taken from the first
+/// directory containing it.
+///
+/// The directories are indexed once (file name to directory), so finding a
+/// file is a single lookup instead of a failing open() for each directory.
+/// A TemplateWatcher refreshes the index when files are added or removed
+/// (without a watcher call refresh()).
+///
+class SearchPathSource : public TemplateSource {
+  public:
+    // Public part
+
+    /// Construct a source and indexes its directories.
+    ///
+    /// @param roots
+    ///     The directories, in search order (each one ending with "/").
+    /// @param mapFiles
+    ///     Map files in memory instead of reading them.
+    ///
+    explicit SearchPathSource(const std::vector<std::string>& roots, bool mapFiles = false);
+
+    /// Indexes the directories again. Reads in progress use the index they
+    /// started with.
+    void refresh() const override;
+
+    /// The directories, in search order.
+    const std::vector<std::string>& roots() const;
+
+    bool read(const std::string& fileName, const std::string& extension,
+              Contents& contents) const override;
+
+    /// The path of the file (or the directories searched if not found).
+    std::string describe(const std::string& fileName,
+                         const std::string& extension) const override;
+
+    /// Files of all the directories (each one once).
+    std::vector<std::string> list(const std::string& extension) const override;
+
+    /// The roots.
+    std::vector<std::string> directories() const override;
+
+  private:
+    // Private part
+
+    /// Index of the directory of each file, by name with extension
+    typedef std::unordered_map<std::string, std::size_t> Index;
+
+    const std::vector<std::string> roots_;
+
+    /// One source for each directory
+    std::vector<DirectorySource> directories_;
+
+    /// Current index (replaced by refresh(): use atomic_load/atomic_store)
+    mutable std::shared_ptr<const Index> index_;
+};
+
+/// Files held in memory (Eg: for tests, or generated at startup).
+class MemorySource : public TemplateSource {
+  public:
+    // Public part
+
+    /// Files by name with extension (Eg: "partials/user.mustache").
+    typedef std::map<std::string, std::string> Files;
+
+    /// Construct a source.
+    ///
+    /// @param files
+    ///     The files. They cannot be changed later.
+    ///
+    explicit MemorySource(const Files& files);
+
+    bool read(const std::string& fileName, const std::string& extension,
+              Contents& contents) const override;
+
+    std::vector<std::string> list(const std::string& extension) const override;
+
+  private:
+    // Private part
+
+    std::map<std::string, std::shared_ptr<const std::string> > files_;
+};
+
+/// A file embedded in the executable.
+struct EmbeddedFile {
+    /// File name with extension (Eg: "partials/user.mustache").
+    const char* name;
+    const char* data;
+    std::size_t size;
+};
+
+/// Files embedded in the executable: they are never copied nor released.
+///
+/// Eg:
+///
+///     static const mustache::EmbeddedFile files[] = {
+///         { "page.mustache", page_mustache, sizeof(page_mustache) - 1 },
+///         ...
+///     };
+///
+class EmbeddedSource : public TemplateSource {
+  public:
+    // Public part
+
+    /// Construct a source.
+    ///
+    /// @param files
+    ///     The files (static data).
+    /// @param count
+    ///     Number of files.
+    ///
+    EmbeddedSource(const EmbeddedFile* files, std::size_t count);
+
+    bool read(const std::string& fileName, const std::string& extension,
+              Contents& contents) const override;
+
+    std::vector<std::string> list(const std::string& extension) const override;
+
+  private:
+    // Private part
+
+    std::map<std::string, const EmbeddedFile*> files_;
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-stats.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+///
+/// @brief      Statistics of a render.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-stats.hpp"
+
+#include <algorithm>
+
+namespace mustache {
+
+RenderStats::RenderStats() {
+    reset();
+}
+
+void RenderStats::reset() {
+    tokens = 0;
+    std::fill(tagsByKind, tagsByKind + TOKEN_KINDS, 0);
+    partialHits = 0;
+    partialMisses = 0;
+    bytesRead = 0;
+    bytesEmitted = 0;
+    escapes = 0;
+    lookups = 0;
+    misses = 0;
+    maxStackDepth = 0;
+    allocations = 0;
+    allocatedBytes = 0;
+    tokenizeTime = std::chrono::nanoseconds::zero();
+    parseContextTime = std::chrono::nanoseconds::zero();
+    renderTime = std::chrono::nanoseconds::zero();
+}
+
+void RenderStats::merge(const RenderStats& other) {
+    tokens += other.tokens;
+    for (std::size_t kind = 0; kind < TOKEN_KINDS; ++kind) {
+        tagsByKind[kind] += other.tagsByKind[kind];
+    }
+    partialHits += other.partialHits;
+    partialMisses += other.partialMisses;
+    bytesRead += other.bytesRead;
+    bytesEmitted += other.bytesEmitted;
+    escapes += other.escapes;
+    lookups += other.lookups;
+    misses += other.misses;
+    maxStackDepth = std::max(maxStackDepth, other.maxStackDepth);
+    allocations += other.allocations;
+    allocatedBytes += other.allocatedBytes;
+    tokenizeTime += other.tokenizeTime;
+    parseContextTime += other.parseContextTime;
+    renderTime += other.renderTime;
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-stats.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Statistics of a render.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+#include "mustache-template.hpp"
+
+namespace mustache {
+
+/// Number of token kinds (see TokenKind).
+const std::size_t TOKEN_KINDS = static_cast<std::size_t>(TokenKind::EndUnescaped) + 1;
+
+/// Statistics of a render, filled when enabled (see Renderer::setStats()).
+///
+/// Partials rendered concurrently and items of parallel sections are
+/// included.
+///
+struct RenderStats {
+    /// All counters and times are zero.
+    RenderStats();
+
+    /// Sets all counters and times to zero.
+    void reset();
+
+    /// Adds counters and times of other (the maximum for maxStackDepth).
+    void merge(const RenderStats& other);
+
+    /// Tags (and text chunks) evaluated of a kind. Eg: tags(StartPartial)
+    /// counts the {{> }} tags rendered, Text the pieces of text copied.
+    std::size_t tags(TokenKind kind) const {
+        return tagsByKind[static_cast<std::size_t>(kind)];
+    }
+
+    /// Tokens processed (tokens of hidden sections are skipped)
+    std::size_t tokens;
+
+    /// See tags()
+    std::size_t tagsByKind[TOKEN_KINDS];
+
+    /// Partials (and dynamic templates) found in the cache
+    std::size_t partialHits;
+
+    /// Partials read from the template source
+    std::size_t partialMisses;
+
+    /// Bytes of the template files read
+    std::size_t bytesRead;
+
+    /// Size of the output
+    std::size_t bytesEmitted;
+
+    /// Values printed through the escape function ({{ var }})
+    std::size_t escapes;
+
+    /// Variables and sections looked up in the context
+    std::size_t lookups;
+
+    /// Lookups that did not find their key
+    std::size_t misses;
+
+    /// Maximum depth of the context stack (1: the context itself)
+    std::size_t maxStackDepth;
+
+    /// Heap allocations made by the rendering thread, and their bytes.
+    /// Counted only when the program installs the counting operators
+    /// (see MUSTACHE_COUNT_ALLOCATIONS()); partials and section items
+    /// rendered by other threads are not included.
+    std::size_t allocations;
+    std::size_t allocatedBytes;
+
+    /// Time spent compiling templates: the view (when compiled by the
+    /// render call, Eg: Mustache::render()), partials read and partials
+    /// with parameters.
+    std::chrono::nanoseconds tokenizeTime;
+
+    /// Time spent parsing the context when given as a string
+    std::chrono::nanoseconds parseContextTime;
+
+    /// Wall time of the render (partials compiled included)
+    std::chrono::nanoseconds renderTime;
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
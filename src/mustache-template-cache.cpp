@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-template-cache.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Compiled template cache with lock-free lookups.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-template-cache.hpp"
+
+#include <string>
+using std::string;
+#include <thread>
+
+namespace mustache {
+
+TemplateCache::TemplateCache() :
+        current_(new Map()), epoch_(0) {
+    for (unsigned i = 0; i < SLOTS; ++i) {
+        slots_[i].readers[0] = 0;
+        slots_[i].readers[1] = 0;
+    }
+}
+
+TemplateCache::~TemplateCache() {
+    delete current_.load();
+}
+
+TemplatePtr TemplateCache::find(const string& key) const {
+    Slot& slot = slots_[threadSlot()];
+    const unsigned epoch = enter(slot);
+    const Map& map = *current_.load();
+    const Map::const_iterator it = map.find(key);
+    const TemplatePtr result = (it == map.end()) ? TemplatePtr() : it->second;
+    leave(slot, epoch);
+    return result;
+}
+
+TemplatePtr TemplateCache::insert(const string& key, const TemplatePtr& compiled) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    // Writers are serialized: the snapshot cannot be deleted meanwhile
+    const Map& map = *current_.load();
+    const Map::const_iterator it = map.find(key);
+    if (it != map.end()) {
+        return it->second;
+    }
+    Map* next = new Map(map);
+    next->insert(std::make_pair(key, compiled));
+    publish(next);
+    return compiled;
+}
+
+void TemplateCache::replace(const string& key, const TemplatePtr& compiled) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    Map* next = new Map(*current_.load());
+    (*next)[key] = compiled;
+    publish(next);
+}
+
+void TemplateCache::erase(const string& key) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    const Map& map = *current_.load();
+    if (map.find(key) == map.end()) {
+        return;
+    }
+    Map* next = new Map(map);
+    next->erase(key);
+    publish(next);
+}
+
+void TemplateCache::erasePrefix(const string& prefix) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    const Map& map = *current_.load();
+    Map::const_iterator it = map.lower_bound(prefix);
+    if (it == map.end() || it->first.compare(0, prefix.size(), prefix) != 0) {
+        return;
+    }
+    Map* next = new Map(map);
+    Map::iterator first = next->lower_bound(prefix);
+    Map::iterator last = first;
+    while (last != next->end() && last->first.compare(0, prefix.size(), prefix) == 0) {
+        ++last;
+    }
+    next->erase(first, last);
+    publish(next);
+}
+
+void TemplateCache::clear() {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    publish(new Map());
+}
+
+std::size_t TemplateCache::size() const {
+    Slot& slot = slots_[threadSlot()];
+    const unsigned epoch = enter(slot);
+    const std::size_t result = current_.load()->size();
+    leave(slot, epoch);
+    return result;
+}
+
+unsigned TemplateCache::enter(Slot& slot) const {
+    for (;;) {
+        const unsigned epoch = epoch_.load();
+        ++slot.readers[epoch];
+        // If a writer switched epoch meanwhile it may have missed this
+        // reader: retry in the new epoch.
+        if (epoch_.load() == epoch) {
+            return epoch;
+        }
+        --slot.readers[epoch];
+    }
+}
+
+void TemplateCache::leave(Slot& slot, unsigned epoch) const {
+    --slot.readers[epoch];
+}
+
+void TemplateCache::publish(Map* next) {
+    const Map* previous = current_.exchange(next);
+
+    // Lookups started from now on use the new epoch: wait for the ones
+    // registered in the old epoch, that may still use previous.
+    const unsigned epoch = epoch_.load();
+    epoch_.store(1 - epoch);
+    for (unsigned i = 0; i < SLOTS; ++i) {
+        while (slots_[i].readers[epoch].load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+    delete previous;
+}
+
+unsigned TemplateCache::threadSlot() {
+    static std::atomic<unsigned> next(0);
+    static thread_local unsigned slot = next++ % SLOTS;
+    return slot;
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
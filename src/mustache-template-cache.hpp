@@ -0,0 +1,144 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-template-cache.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Compiled template cache with lock-free lookups.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+
+#include "mustache-template.hpp"
+
+namespace mustache {
+
+/// Compiled templates by name.
+///
+/// Lookups never take a lock: the templates are held by an immutable
+/// snapshot, that writers copy, change and publish atomically. A snapshot
+/// is deleted when no lookup uses it anymore: lookups register themselves
+/// in a reader counter of the current epoch and writers, after publishing,
+/// switch epoch and wait for the counters of the previous one (lookups last
+/// only the time of a map search).
+///
+/// Writers are serialized. Templates already returned by a lookup are
+/// shared pointers, so renders in progress are never blocked nor affected.
+///
+class TemplateCache {
+  public:
+    // Public part
+
+    TemplateCache();
+    ~TemplateCache();
+
+    /// Searches a template (lock-free).
+    ///
+    /// @return
+    ///     The template or nullptr if key is not cached.
+    ///
+    TemplatePtr find(const std::string& key) const;
+
+    /// Adds a template. If key is already cached the cached template is
+    /// kept and returned (another thread compiled it first).
+    TemplatePtr insert(const std::string& key, const TemplatePtr& compiled);
+
+    /// Adds or replaces a template.
+    void replace(const std::string& key, const TemplatePtr& compiled);
+
+    /// Removes a template (if cached).
+    void erase(const std::string& key);
+
+    /// Removes all the templates whose key starts with prefix.
+    void erasePrefix(const std::string& prefix);
+
+    /// Removes all the templates.
+    void clear();
+
+    /// Number of cached templates.
+    std::size_t size() const;
+
+  private:
+    // Private part
+
+    typedef std::map<std::string, TemplatePtr> Map;
+
+    /// Reader counters are spread on slots, one for each thread (threads
+    /// share slots when there are more than SLOTS).
+    static const unsigned SLOTS = 32;
+
+    /// Reader counters of the two epochs, padded to a cache line so
+    /// threads do not write the same line.
+    struct Slot {
+        std::atomic<std::size_t> readers[2];
+        char padding[64 - 2 * sizeof(std::atomic<std::size_t>)];
+    };
+
+    /// Registers a lookup in the current epoch.
+    ///
+    /// @return
+    ///     The epoch, to be passed to leave().
+    ///
+    unsigned enter(Slot& slot) const;
+
+    /// Ends a lookup started by enter().
+    void leave(Slot& slot, unsigned epoch) const;
+
+    /// Publishes next as current snapshot and deletes the previous one
+    /// when no lookup uses it. writeMutex_ must be locked.
+    void publish(Map* next);
+
+    /// Slot of the calling thread.
+    static unsigned threadSlot();
+
+    /// Current snapshot
+    std::atomic<const Map*> current_;
+
+    /// Current epoch (0 or 1)
+    std::atomic<unsigned> epoch_;
+
+    mutable Slot slots_[SLOTS];
+
+    /// Serializes writers
+    std::mutex writeMutex_;
+
+    // Disallow copy constructor and assign operator
+    TemplateCache(const TemplateCache&);
+    void operator=(const TemplateCache&);
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,279 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-template-store.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Compiled templates shared by processes through mapped memory.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-template-store.hpp"
+#include "./mustache-engine.hpp"
+#include "./mustache-exception.hpp"
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+// getpid
+#include <unistd.h>
+
+namespace mustache {
+
+static const char STORE_MAGIC[8] = { 'M', 'U', 'S', 'T', 'S', 'T', 'O', 'R' };
+static const std::uint32_t STORE_VERSION = 1;
+
+struct TemplateStore::Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t templates;
+    std::uint32_t tokens;
+    std::uint32_t padding;
+    std::uint64_t size;
+};
+
+struct TemplateStore::Entry {
+    std::uint32_t nameOffset;
+    std::uint32_t nameSize;
+    std::uint32_t firstToken;
+    std::uint32_t tokenCount;
+};
+
+struct TemplateStore::TokenRecord {
+    std::uint32_t textOffset;
+    std::uint32_t textSize;
+    std::uint8_t kind;
+    std::uint8_t padding[3];
+};
+
+// Offsets are 32 bits
+static std::uint32_t checkedOffset(std::size_t value) {
+    if (value > UINT32_MAX) {
+        throw RenderException("Template store too big");
+    }
+    return static_cast<std::uint32_t>(value);
+}
+
+// Compares names like std::string does
+static int compareName(const char* name, std::size_t size, const string& other) {
+    const int result = std::memcmp(name, other.data(), std::min(size, other.size()));
+    if (result != 0) {
+        return result;
+    }
+    return (size < other.size()) ? -1 : ((size > other.size()) ? 1 : 0);
+}
+
+void TemplateStore::write(const string& path, const Engine& engine,
+                          const vector<string>& fileNames) {
+    vector<string> names(fileNames);
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    vector<TemplatePtr> templates;
+    std::size_t tokenCount = 0;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        templates.push_back(engine.load(names[i]));
+        tokenCount += templates.back()->size();
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+    header.version = STORE_VERSION;
+    header.templates = checkedOffset(names.size());
+    header.tokens = checkedOffset(tokenCount);
+
+    // Texts follow the tables
+    vector<Entry> entries(names.size());
+    vector<TokenRecord> records(tokenCount);
+    string texts;
+    const std::size_t textOffset = sizeof(Header) + entries.size() * sizeof(Entry) +
+                                   records.size() * sizeof(TokenRecord);
+    std::size_t token = 0;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        Entry& entry = entries[i];
+        entry.nameOffset = checkedOffset(textOffset + texts.size());
+        entry.nameSize = checkedOffset(names[i].size());
+        entry.firstToken = checkedOffset(token);
+        entry.tokenCount = checkedOffset(templates[i]->size());
+        texts.append(names[i]);
+        const Template& compiled = *templates[i];
+        for (Template::TokenIndex t = 0; t < compiled.size(); ++t, ++token) {
+            TokenRecord& record = records[token];
+            std::memset(&record, 0, sizeof(record));
+            record.textOffset = checkedOffset(textOffset + texts.size());
+            record.textSize = checkedOffset(compiled.length(t));
+            record.kind = static_cast<std::uint8_t>(compiled.kind(t));
+            texts.append(compiled.data(t), compiled.length(t));
+        }
+    }
+    header.size = textOffset + texts.size();
+    checkedOffset(header.size);
+
+    // Write aside, then replace the file at once
+    const string temporary = path + ".tmp." + std::to_string(::getpid());
+    std::ofstream out(temporary.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!entries.empty()) {
+        out.write(reinterpret_cast<const char*>(&entries[0]), entries.size() * sizeof(Entry));
+    }
+    if (!records.empty()) {
+        out.write(reinterpret_cast<const char*>(&records[0]), records.size() * sizeof(TokenRecord));
+    }
+    out.write(texts.data(), texts.size());
+    out.close();
+    if (!out || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw RenderException("Cannot write template store: " + path);
+    }
+}
+
+TemplateStorePtr TemplateStore::open(const string& path) {
+    const MappedFilePtr file = MappedFile::open(path);
+    if (!file) {
+        throw RenderException("Cannot open template store: " + path);
+    }
+    TemplateStorePtr store(new TemplateStore(file));
+    if (!store->valid()) {
+        throw RenderException("Invalid template store: " + path);
+    }
+    store->built_.resize(store->header().templates);
+    return store;
+}
+
+TemplateStore::TemplateStore(const MappedFilePtr& file) :
+        file_(file), data_(file->data()), size_(file->size()) {
+}
+
+TemplateStore::~TemplateStore() {
+}
+
+TemplatePtr TemplateStore::find(const string& fileName) const {
+    const Entry* first = entries();
+    const Entry* last = first + header().templates;
+    const Entry* entry = std::lower_bound(first, last, fileName,
+        [this](const Entry& e, const string& name) {
+            return compareName(data_ + e.nameOffset, e.nameSize, name) < 0;
+        });
+    if (entry == last || compareName(data_ + entry->nameOffset, entry->nameSize, fileName) != 0) {
+        return TemplatePtr();
+    }
+    return get(entry);
+}
+
+void TemplateStore::build() const {
+    const Entry* entry = entries();
+    for (std::uint32_t i = 0; i < header().templates; ++i, ++entry) {
+        get(entry);
+    }
+}
+
+TemplatePtr TemplateStore::get(const Entry* entry) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TemplatePtr& built = built_[entry - entries()];
+    if (built) {
+        return built;
+    }
+
+    vector<TokenKind> kinds(entry->tokenCount);
+    vector<Template::TextView> texts(entry->tokenCount);
+    const TokenRecord* record = records() + entry->firstToken;
+    for (std::uint32_t i = 0; i < entry->tokenCount; ++i, ++record) {
+        kinds[i] = static_cast<TokenKind>(record->kind);
+        texts[i].data = data_ + record->textOffset;
+        texts[i].size = record->textSize;
+    }
+    // The mapping, not the store, is kept by the template: the store keeps
+    // its templates
+    built = std::make_shared<const Template>(kinds, texts, file_);
+    return built;
+}
+
+vector<string> TemplateStore::names() const {
+    vector<string> result;
+    const Entry* entry = entries();
+    for (std::uint32_t i = 0; i < header().templates; ++i, ++entry) {
+        result.push_back(string(data_ + entry->nameOffset, entry->nameSize));
+    }
+    return result;
+}
+
+std::size_t TemplateStore::bytes() const {
+    return size_;
+}
+
+const TemplateStore::Header& TemplateStore::header() const {
+    return *reinterpret_cast<const Header*>(data_);
+}
+
+const TemplateStore::Entry* TemplateStore::entries() const {
+    return reinterpret_cast<const Entry*>(data_ + sizeof(Header));
+}
+
+const TemplateStore::TokenRecord* TemplateStore::records() const {
+    return reinterpret_cast<const TokenRecord*>(entries() + header().templates);
+}
+
+bool TemplateStore::valid() const {
+    if (size_ < sizeof(Header)) {
+        return false;
+    }
+    const Header& h = header();
+    const std::uint64_t tables = sizeof(Header) +
+                                 static_cast<std::uint64_t>(h.templates) * sizeof(Entry) +
+                                 static_cast<std::uint64_t>(h.tokens) * sizeof(TokenRecord);
+    if (std::memcmp(h.magic, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0 ||
+        h.version != STORE_VERSION || h.size != size_ || tables > size_) {
+        return false;
+    }
+    const Entry* entry = entries();
+    for (std::uint32_t i = 0; i < h.templates; ++i, ++entry) {
+        if (static_cast<std::uint64_t>(entry->nameOffset) + entry->nameSize > size_ ||
+            static_cast<std::uint64_t>(entry->firstToken) + entry->tokenCount > h.tokens) {
+            return false;
+        }
+    }
+    const TokenRecord* record = records();
+    for (std::uint32_t i = 0; i < h.tokens; ++i, ++record) {
+        if (static_cast<std::uint64_t>(record->textOffset) + record->textSize > size_ ||
+            record->kind > static_cast<std::uint8_t>(TokenKind::EndUnescaped)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
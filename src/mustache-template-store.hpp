@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-template-store.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Compiled templates shared by processes through mapped memory.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+
+#include "mustache-template.hpp"
+#include "mustache-mapped-file.hpp"
+
+namespace mustache {
+
+class Engine;
+
+/// Compiled templates in a file mapped read-only in memory.
+///
+/// A process (Eg: the parent of a prefork server) compiles the templates
+/// and writes them with write(); every process opens the file and shares
+/// its pages, so the memory for the template text is paid once per host.
+/// Put the file in /dev/shm to keep it in POSIX shared memory.
+///
+/// The layout is position independent (offsets, no pointers):
+///
+///     Header                                  magic, version, counts
+///     Entry[templates]                        sorted by name
+///     TokenRecord[tokens]                     kind and text of each token
+///     char[]                                  names and token texts
+///
+/// Templates returned by find() point into the mapping and keep it alive.
+/// Tags are decomposed into strings of the process (context lookups need
+/// them): each template is built once per process, on its first find(),
+/// and kept by the store. Building them before forking (see build())
+/// shares them among the children too, copy-on-write.
+///
+class TemplateStore {
+  public:
+    // Public part
+
+    /// Compiles (or takes from the engine cache) template files and writes
+    /// them to a store file. The file is written aside and renamed, so
+    /// processes mapping the previous version are not affected.
+    ///
+    /// @param path
+    ///     The store file (Eg: "/dev/shm/myapp-templates").
+    /// @param engine
+    ///     The engine loading the templates.
+    /// @param fileNames
+    ///     Template file names, relative to the engine base path and without
+    ///     extension.
+    ///
+    /// @throws RenderException
+    ///     If a template file or the store file cannot be opened or written.
+    ///
+    static void write(const std::string& path, const Engine& engine,
+                      const std::vector<std::string>& fileNames);
+
+    /// Maps a store file read-only.
+    ///
+    /// @param path
+    ///     The store file.
+    ///
+    /// @return
+    ///     The store.
+    ///
+    /// @throws RenderException
+    ///     If the file cannot be mapped or it's not a valid store.
+    ///
+    static std::shared_ptr<const TemplateStore> open(const std::string& path);
+
+    ~TemplateStore();
+
+    /// Searches a template.
+    ///
+    /// @param fileName
+    ///     The template file name (as given to write()).
+    ///
+    /// @return
+    ///     The template (its text is in the mapping) or nullptr. Every
+    ///     call returns the same template.
+    ///
+    TemplatePtr find(const std::string& fileName) const;
+
+    /// Builds all the templates (Eg: in the parent process of a prefork
+    /// server, before forking).
+    void build() const;
+
+    /// Names of the templates in the store.
+    std::vector<std::string> names() const;
+
+    /// Size of the mapping in bytes.
+    std::size_t bytes() const;
+
+  private:
+    // Private part
+
+    struct Header;
+    struct Entry;
+    struct TokenRecord;
+
+    const MappedFilePtr file_;
+
+    /// The mapping
+    const char* data_;
+    std::size_t size_;
+
+    /// Templates already built, by entry (see find())
+    mutable std::mutex mutex_;
+    mutable std::vector<TemplatePtr> built_;
+
+    const Header& header() const;
+    const Entry* entries() const;
+    const TokenRecord* records() const;
+
+    /// Checks that all the offsets are inside the mapping.
+    bool valid() const;
+
+    /// The template of an entry (built if needed).
+    TemplatePtr get(const Entry* entry) const;
+
+    explicit TemplateStore(const MappedFilePtr& file);
+
+    // Disallow default constructor, copy constructor and assign operator
+    TemplateStore();
+    TemplateStore(const TemplateStore&);
+    void operator=(const TemplateStore&);
+};
+
+typedef std::shared_ptr<const TemplateStore> TemplateStorePtr;
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,411 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-template.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Compiled (tokenized) templates.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-template.hpp"
+#include "./mustache-format.hpp"
+#include "./mustache-internal.hpp"
+
+#include <cctype>
+#include <atomic>
+
+using std::string;
+#include <vector>
+using std::vector;
+
+namespace mustache {
+
+/// A new template identifier (see Template::id()).
+static std::uint64_t newTemplateId() {
+    static std::atomic<std::uint64_t> last(0);
+    return ++last;
+}
+
+const string& tokenKindText(TokenKind kind) {
+    static const string texts[] = {
+        "(txt)", "{{", "{{{", "{{!", "{{#", "{{/", "{{=", "{{0", "{{^",
+        "{{>", "{{<", "}}", "}}}"
+    };
+    return texts[static_cast<unsigned char>(kind)];
+}
+
+Template::Template(const string& view) :
+        source_(view), begin_(nullptr), id_(newTemplateId()) {
+    tokenize(source_.data(), source_.size());
+}
+
+Template::Template(const char* data, std::size_t size,
+                   const std::shared_ptr<const void>& storage) :
+        storage_(storage), begin_(nullptr), id_(newTemplateId()) {
+    tokenize(data, size);
+}
+
+Template::Template(Tokens&& tokens) :
+        tokens_(std::move(tokens)), begin_(nullptr), id_(newTemplateId()) {
+    makeViews();
+    makeSectionEnds();
+    makeTagInfo();
+}
+
+Template::Template(const std::vector<TokenKind>& kinds, const std::vector<TextView>& texts,
+                   const std::shared_ptr<const void>& storage) :
+        tokens_(kinds.size()), views_(texts), storage_(storage), begin_(nullptr),
+        id_(newTemplateId()) {
+    for (TokenIndex i = 0; i < kinds.size(); ++i) {
+        tokens_[i].kind = kinds[i];
+    }
+    makeTags();
+    makeSectionEnds();
+    makeTagInfo();
+}
+
+Template::Position Template::position(TokenIndex index) const {
+    Position position = { 0, 0 };
+    if (begin_ == nullptr || index >= views_.size()) {
+        return position;
+    }
+    position.line = 1;
+    position.column = 1;
+    for (const char* ch = begin_; ch < views_[index].data; ++ch) {
+        if (*ch == '\n') {
+            ++position.line;
+            position.column = 1;
+        } else {
+            ++position.column;
+        }
+    }
+    return position;
+}
+
+Template::Tokens Template::tokens() const {
+    Tokens tokens(tokens_.size());
+    for (TokenIndex i = 0; i < tokens_.size(); ++i) {
+        tokens[i].kind = tokens_[i].kind;
+        tokens[i].text.assign(views_[i].data, views_[i].size);
+    }
+    return tokens;
+}
+
+void Template::makeTags() {
+    for (TokenIndex i = 0; i < tokens_.size(); ++i) {
+        if (isTag(i)) {
+            tokens_[i].text.assign(views_[i].data, views_[i].size);
+        }
+    }
+}
+
+void Template::makeViews() {
+    views_.resize(tokens_.size());
+    for (TokenIndex i = 0; i < tokens_.size(); ++i) {
+        views_[i].data = tokens_[i].text.data();
+        views_[i].size = tokens_[i].text.size();
+    }
+}
+
+void Template::makeSectionEnds() {
+    sectionEnds_.assign(tokens_.size(), tokens_.size());
+    std::vector<TokenIndex> open;
+    for (TokenIndex i = 0; i < tokens_.size(); ++i) {
+        switch (tokens_[i].kind) {
+        case TokenKind::StartBeginSection:
+        case TokenKind::StartIf:
+        case TokenKind::StartUnless:
+        case TokenKind::StartExistsTest:
+            open.push_back(i);
+            break;
+        case TokenKind::StartEndSection:
+            if (!open.empty()) {
+                sectionEnds_[open.back()] = i;
+                open.pop_back();
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/// Valid characters of identifiers (variables and sections).
+static const char VALID_CHARS_FOR_ID[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_@[]";
+
+/// Valid characters of partial tags (name and parameters).
+static const char VALID_CHARS_FOR_PARTIALS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_/|=[]().,;!?\"' \n\r°&";
+
+/// Character classes, indexed by character.
+enum CharClass : unsigned char {
+    CHAR_ID = 1,        ///< In VALID_CHARS_FOR_ID
+    CHAR_PARTIAL = 2    ///< In VALID_CHARS_FOR_PARTIALS
+};
+
+static const unsigned char* charClasses() {
+    struct Table {
+        unsigned char classes[256];
+        Table() {
+            for (int ch = 0; ch < 256; ++ch) {
+                classes[ch] = 0;
+            }
+            for (const char* ch = VALID_CHARS_FOR_ID; *ch != '\0'; ++ch) {
+                classes[static_cast<unsigned char>(*ch)] |= CHAR_ID;
+            }
+            for (const char* ch = VALID_CHARS_FOR_PARTIALS; *ch != '\0'; ++ch) {
+                classes[static_cast<unsigned char>(*ch)] |= CHAR_PARTIAL;
+            }
+        }
+    };
+    static const Table table;
+    return table.classes;
+}
+
+/// Checks that id contains only characters of a class.
+///
+/// @return
+///     The error message (empty if id is valid).
+///
+static string validateIdentifier(const string& id, CharClass charClass, const char* validChars) {
+    const unsigned char* classes = charClasses();
+    for (string::size_type i = 0; i < id.size(); ++i) {
+        if ((classes[static_cast<unsigned char>(id[i])] & charClass) == 0) {
+            return "Invalid identifier '" + id + "': bad char '" + id[i] + "' at index " +
+                   std::to_string(i) + " valid are " + validChars;
+        }
+    }
+    return string();
+}
+
+/// Splits an identifier into key and array selection (Eg: "items[2]").
+static void decomposeIdentifier(const string& id, Template::Tag& tag) {
+    typedef Template::Tag Tag;
+    tag.key = id;
+    if (id == "@index") {
+        tag.special = Tag::Special::Index;
+    } else if (id == "@first") {
+        tag.special = Tag::Special::First;
+    }
+
+    const string::size_type start = id.find('[');
+    if (start == string::npos) {
+        return;
+    }
+    const string::size_type stop = id.find(']');
+    if (stop == string::npos) {
+        tag.selectionError = "Missing ] in array selection";
+        return;
+    }
+    if (start + 1 == stop) {
+        tag.selectionError = "Index is empty";
+        return;
+    }
+    tag.key = id.substr(0, start);
+    // Leading digits are the index (an index without digits is never
+    // found)
+    tag.selection = Tag::Selection::Index;
+    tag.index = 0;
+    string::size_type digit = start + 1;
+    for (; digit < id.size() && id[digit] >= '0' && id[digit] <= '9'; ++digit) {
+        const std::size_t next = tag.index * 10 + static_cast<std::size_t>(id[digit] - '0');
+        if (next / 10 != tag.index) {
+            tag.selection = Tag::Selection::Invalid;
+            return;
+        }
+        tag.index = next;
+    }
+    if (digit == start + 1) {
+        tag.selection = Tag::Selection::Invalid;
+    }
+}
+
+void Template::makeTagInfo() {
+    tags_.assign(tokens_.size(), Tag());
+    for (TokenIndex i = 1; i < tokens_.size(); ++i) {
+        if (!isTag(i)) {
+            continue;
+        }
+        const string& text = tokens_[i].text;
+        Tag& tag = tags_[i];
+        tag.special = Tag::Special::None;
+        tag.selection = Tag::Selection::None;
+        tag.index = 0;
+        tag.decimals = NUMBER_FORMAT_DEFAULT;
+        switch (tokens_[i - 1].kind) {
+        case TokenKind::StartVariable:
+        case TokenKind::StartVariableUnescaped: {
+            // Split the optional number format. Eg: {{ price:.2 }}
+            tag.name = text;
+            const string::size_type separator = text.find(NUMBER_FORMAT_SEPARATOR);
+            if (separator != string::npos) {
+                tag.name = text.substr(0, separator);
+                rtrim(tag.name);
+                const string::size_type format = text.find_first_not_of(" \t", separator + 1);
+                if (format == string::npos ||
+                    !parseNumberFormat(text.data() + format, text.size() - format, tag.decimals)) {
+                    tag.error = "Invalid number format in '" + text + "'";
+                }
+            }
+            if (tag.error.empty()) {
+                tag.error = validateIdentifier(tag.name, CHAR_ID, VALID_CHARS_FOR_ID);
+            }
+            decomposeIdentifier(tag.name, tag);
+            break;
+        }
+        case TokenKind::StartBeginSection:
+        case TokenKind::StartIf:
+        case TokenKind::StartUnless:
+        case TokenKind::StartExistsTest:
+            tag.name = text;
+            tag.error = validateIdentifier(text, CHAR_ID, VALID_CHARS_FOR_ID);
+            decomposeIdentifier(text, tag);
+            break;
+        case TokenKind::StartPartial:
+        case TokenKind::StartTemplate: {
+            // Eg: paragraph|title=SampleTitle|text=SampleText
+            tag.error = validateIdentifier(text, CHAR_PARTIAL, VALID_CHARS_FOR_PARTIALS);
+            vector<string> splitted = split(text, '|');
+            for (size_t p = 0; p < splitted.size(); ++p) {
+                trim(splitted[p]);
+            }
+            if (splitted.empty()) {
+                if (tag.error.empty()) {
+                    tag.error = "Missing partial name";
+                }
+                break;
+            }
+            tag.name = splitted[0];
+            tag.parameters.assign(splitted.begin() + 1, splitted.end());
+            if (tokens_[i - 1].kind == TokenKind::StartTemplate) {
+                decomposeIdentifier(tag.name, tag);
+            }
+            break;
+        }
+        default:
+            // Comments and section ends
+            break;
+        }
+    }
+}
+
+void Template::addToken(TokenKind kind, const char* data, std::size_t size) {
+    const Token token = { kind, string() };
+    const TextView view = { data, size };
+    tokens_.push_back(token);
+    views_.push_back(view);
+}
+
+void Template::tokenize(const char* data, std::size_t size) {
+        // Characters past the end read as '\0': data may not be terminated
+        const auto at = [data, size](std::size_t i) {
+                return (i < size) ? data[i] : '\0';
+        };
+        const auto isSpace = [](char ch) {
+                return std::isspace(static_cast<unsigned char>(ch)) != 0;
+        };
+        begin_ = data;
+        std::size_t start = 0;
+        std::size_t prev = 0;
+        std::size_t pos;
+
+        for (;;) {
+                pos = prev;
+                while (pos < size && data[pos] != '{' && data[pos] != '}') {
+                        ++pos;
+                }
+                if (pos == size) {
+                        break;
+                }
+                if (data[pos] == '{') {
+                        if (at(pos + 1) == '{') {
+                                // Insert into tokens text encountered until "{{"
+                                addToken(TokenKind::Text, data + start, pos - start);
+                                TokenKind kind;
+                                prev = pos + 3;
+                                switch (at(pos + 2)) {
+                                case '#': kind = TokenKind::StartBeginSection;  break;
+                                case '=': kind = TokenKind::StartIf;            break;
+                                case '^': kind = TokenKind::StartUnless;        break;
+                                case '0': kind = TokenKind::StartExistsTest;    break;
+                                case '/': kind = TokenKind::StartEndSection;    break;
+                                case '>': kind = TokenKind::StartPartial;       break;
+                                case '<': kind = TokenKind::StartTemplate;      break;
+                                case '!': kind = TokenKind::StartComment;       break;
+                                case '{': kind = TokenKind::StartVariableUnescaped; break;
+                                default:
+                                        kind = TokenKind::StartVariable;
+                                        prev = pos + 2;
+                                        break;
+                                }
+                                // Delimiters carry no text
+                                addToken(kind, data + pos, 0);
+                                start = prev;
+                        } else {
+                                // Single open {: continue..
+                                prev = pos + 1;
+                        }
+                } else {
+                        if (at(pos + 1) == '}') {
+                                // Trim text inside parenthesis.
+                                // Eg: "{{ some }}" => " some " => "some"
+                                std::size_t first = start;
+                                std::size_t last = pos;
+                                while (first < last && isSpace(data[first])) {
+                                        ++first;
+                                }
+                                while (last > first && isSpace(data[last - 1])) {
+                                        --last;
+                                }
+                                // Now save both token and closed parenthesis "}}"
+                                addToken(TokenKind::Text, data + first, last - first);
+                                if (at(pos + 2) == '}') {
+                                        addToken(TokenKind::EndUnescaped, data + pos, 0);
+                                        prev = pos + 3;
+                                } else {
+                                        addToken(TokenKind::End, data + pos, 0);
+                                        prev = pos + 2;
+                                }
+                                start = prev;
+                        } else {
+                                // Single close }: continue..
+                                prev = pos + 1;
+                        }
+                }
+        }
+        // Save last part of the file (if any) as free text
+        addToken(TokenKind::Text, data + start, size - start);
+
+        makeTags();
+        makeSectionEnds();
+        makeTagInfo();
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,317 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-template.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Compiled (tokenized) templates.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace mustache {
+
+/// Kinds of token.
+/// Every token but Text is a delimiter; Text is free text (both the text
+/// outside tags and the trimmed content of tags).
+///
+enum class TokenKind : unsigned char {
+    Text,                   ///< (txt)
+    StartVariable,          ///< {{
+    StartVariableUnescaped, ///< {{{
+    StartComment,           ///< {{!
+    StartBeginSection,      ///< {{#
+    StartEndSection,        ///< {{/
+    StartIf,                ///< {{=
+    StartExistsTest,        ///< {{0
+    StartUnless,            ///< {{^
+    StartPartial,           ///< {{>
+    StartTemplate,          ///< {{<
+    End,                    ///< }}
+    EndUnescaped            ///< }}}
+};
+
+/// Returns the text of a token kind. Eg: "{{#" for StartBeginSection.
+///
+/// @param kind
+///     The token kind.
+///
+/// @return
+///     The delimiter or "(txt)" for Text.
+///
+const std::string& tokenKindText(TokenKind kind);
+
+/// A template compiled into a sequence of tokens.
+///
+/// Templates are immutable once built, so a single compiled template can be
+/// shared by any number of threads (see Engine).
+///
+class Template {
+  public:
+    // Public part
+
+    typedef std::size_t TokenIndex;
+
+    /// A single token.
+    struct Token {
+        TokenKind kind;
+
+        /// Content of Text tokens (empty for delimiters).
+        std::string text;
+    };
+
+    typedef std::vector<Token> Tokens;
+
+    /// A tag decomposed when the template is compiled (see tag()): renders
+    /// never parse nor validate tag text.
+    struct Tag {
+        /// Special variables
+        enum class Special : unsigned char {
+            None,
+            Index,  ///< @index
+            First   ///< @first
+        };
+
+        /// Array selections (Eg: "items[2]")
+        enum class Selection : unsigned char {
+            None,
+            Index,      ///< A valid index
+            Invalid     ///< Not a number: the variable is never found
+        };
+
+        /// The identifier: variable (without number format), section
+        /// variable or partial file name (for {{< }} the variable holding
+        /// it). Used in error messages.
+        std::string name;
+
+        /// The key looked up in the context (name without array selection).
+        std::string key;
+
+        Special special;
+
+        Selection selection;
+
+        /// Index of the array selection (if any).
+        std::size_t index;
+
+        /// Decimals of the number format (Eg: 2 for {{ price:.2 }}), or
+        /// NUMBER_FORMAT_DEFAULT.
+        int decimals;
+
+        /// Partial parameters (Eg: "Name='Mario'" in
+        /// {{> user | Name='Mario' }}).
+        std::vector<std::string> parameters;
+
+        /// Error raised when the tag is rendered (Eg: invalid characters),
+        /// empty if the tag is valid.
+        std::string error;
+
+        /// Error raised when the variable is looked up in a context (a
+        /// malformed array selection, Eg: "items[").
+        std::string selectionError;
+    };
+
+    /// A piece of text (not null terminated).
+    struct TextView {
+        const char* data;
+        std::size_t size;
+    };
+
+    /// Position of a token in the view (1-based).
+    struct Position {
+        std::size_t line;
+        std::size_t column;
+    };
+
+    /// Compiles a view.
+    ///
+    /// @param view
+    ///     The view with {{ ... }} tags.
+    ///
+    explicit Template(const std::string& view);
+
+    /// Compiles a view in memory the template does not own (Eg: a mapped
+    /// file). Text is not copied, but tags.
+    ///
+    /// @param data
+    ///     The view with {{ ... }} tags.
+    /// @param size
+    ///     Size of the view.
+    /// @param storage
+    ///     Keeps data alive as long as the template.
+    ///
+    Template(const char* data, std::size_t size, const std::shared_ptr<const void>& storage);
+
+    /// Builds a template from already compiled tokens.
+    ///
+    /// @param tokens
+    ///     The tokens.
+    ///
+    explicit Template(Tokens&& tokens);
+
+    /// Builds a template whose text lives in memory it does not own (Eg: a
+    /// shared memory segment, see TemplateStore). Only tags are copied.
+    ///
+    /// @param kinds
+    ///     The kind of each token.
+    /// @param texts
+    ///     The text of each token.
+    /// @param storage
+    ///     Keeps the memory of texts alive as long as the template.
+    ///
+    Template(const std::vector<TokenKind>& kinds, const std::vector<TextView>& texts,
+             const std::shared_ptr<const void>& storage);
+
+    /// Identifier of the template, unique in the process (templates
+    /// allocated at the address of a destroyed one get a new identifier).
+    std::uint64_t id() const {
+        return id_;
+    }
+
+    /// Number of tokens.
+    std::size_t size() const {
+        return tokens_.size();
+    }
+
+    /// Kind of the token at index.
+    TokenKind kind(TokenIndex index) const {
+        return tokens_[index].kind;
+    }
+
+    /// Text of the token at index (empty for delimiters).
+    const char* data(TokenIndex index) const {
+        return views_[index].data;
+    }
+
+    /// Size of the text of the token at index.
+    std::size_t length(TokenIndex index) const {
+        return views_[index].size;
+    }
+
+    /// Text of a tag (the Text token after a start delimiter, Eg: "name" in
+    /// {{ name }}) as a string. Text outside tags is not copied into
+    /// strings (unless the template is built from Tokens): use data() and
+    /// length() for any token.
+    const std::string& text(TokenIndex index) const {
+        return tokens_[index].text;
+    }
+
+    /// Index of the {{/ token closing the section opened at index (by
+    /// {{#, {{=, {{^ or {{0), or size() if it's not closed. Hidden
+    /// sections jump there instead of being walked.
+    TokenIndex sectionEnd(TokenIndex index) const {
+        return sectionEnds_[index];
+    }
+
+    /// Decomposed tag (the Text token after a start delimiter, but
+    /// comments and section ends).
+    const Tag& tag(TokenIndex index) const {
+        return tags_[index];
+    }
+
+    /// Position of the token at index in the compiled view, or 0, 0 if
+    /// unknown (templates built from tokens, Eg: partials with parameters).
+    /// The view is scanned from the beginning: it's meant for reports.
+    Position position(TokenIndex index) const;
+
+    /// Returns a copy of all the tokens (with all their text).
+    Tokens tokens() const;
+
+    /// true if the text at index is the content of a tag.
+    bool isTag(TokenIndex index) const {
+        return index > 0 && tokens_[index].kind == TokenKind::Text &&
+               tokens_[index - 1].kind != TokenKind::Text &&
+               tokens_[index - 1].kind != TokenKind::End &&
+               tokens_[index - 1].kind != TokenKind::EndUnescaped;
+    }
+
+  private:
+    // Private part
+
+    /// Text is set for tags only, but for templates built from Tokens
+    Tokens tokens_;
+
+    /// Text of each token (in tokens_, source_ or storage_)
+    std::vector<TextView> views_;
+
+    /// The compiled view (if owned)
+    std::string source_;
+
+    /// Memory holding the text (if not owned)
+    std::shared_ptr<const void> storage_;
+
+    /// See sectionEnd() (size() for tokens not opening a section)
+    std::vector<TokenIndex> sectionEnds_;
+
+    /// See tag() (empty for tokens that are not tags)
+    std::vector<Tag> tags_;
+
+    /// Beginning of the compiled view (see position()), nullptr if the
+    /// template was built from tokens
+    const char* begin_;
+
+    /// See id()
+    std::uint64_t id_;
+
+    /// Splits a view into tokens: fills tokens_ and views_.
+    void tokenize(const char* data, std::size_t size);
+
+    /// Adds a token to tokens_ and views_.
+    void addToken(TokenKind kind, const char* data, std::size_t size);
+
+    /// Sets the text of tags in tokens_.
+    void makeTags();
+
+    /// Fills views_ with the text of tokens_.
+    void makeViews();
+
+    /// Fills sectionEnds_ matching sections like the renderer does: {{/
+    /// closes the innermost open section.
+    void makeSectionEnds();
+
+    /// Fills tags_ (decomposes and validates tags).
+    void makeTagInfo();
+
+    // Disallow copy constructor and assign operator: views_ point into
+    // tokens_
+    Template(const Template&);
+    void operator=(const Template&);
+};
+
+typedef std::shared_ptr<const Template> TemplatePtr;
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
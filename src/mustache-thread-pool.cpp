@@ -0,0 +1,208 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-thread-pool.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Work-stealing thread pool.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-thread-pool.hpp"
+
+#include <chrono>
+
+namespace mustache {
+
+// The pool (and the index inside it) of the current worker thread
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local unsigned currentIndex = 0;
+
+ThreadPool::ThreadPool(unsigned threads) :
+        pending_(0), next_(0), stop_(false) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        queues_.push_back(std::unique_ptr<Queue>(new Queue()));
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        threads_.push_back(std::thread(&ThreadPool::work, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        stop_ = true;
+    }
+    idle_.notify_all();
+    for (std::size_t i = 0; i < threads_.size(); ++i) {
+        threads_.at(i).join();
+    }
+}
+
+unsigned ThreadPool::size() const {
+    return static_cast<unsigned>(queues_.size());
+}
+
+unsigned ThreadPool::workerIndex() const {
+    return currentPool == this ? currentIndex : size();
+}
+
+void ThreadPool::submit(Task task) {
+    unsigned index = workerIndex();
+    if (index == size()) {
+        index = next_++ % size();
+    }
+    // Count the task before it becomes visible, so the counter never
+    // goes below the real number of queued tasks.
+    {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        ++pending_;
+    }
+    {
+        Queue& queue = *queues_.at(index);
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    idle_.notify_one();
+}
+
+bool ThreadPool::runPending() {
+    Task task;
+    unsigned index = workerIndex();
+    if (!take(index == size() ? 0 : index, task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+bool ThreadPool::take(unsigned index, Task& task) {
+    if (pending_ == 0) {
+        return false;
+    }
+    // Own queue: newest task (still hot in cache)
+    {
+        Queue& queue = *queues_.at(index);
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            --pending_;
+            return true;
+        }
+    }
+    // Steal the oldest task from the others
+    for (unsigned i = 1; i < size(); ++i) {
+        Queue& queue = *queues_.at((index + i) % size());
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            --pending_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::work(unsigned index) {
+    currentPool = this;
+    currentIndex = index;
+
+    Task task;
+    while (true) {
+        if (take(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(idleMutex_);
+        idle_.wait(lock, [this]() { return stop_ || pending_ > 0; });
+        if (stop_ && pending_ == 0) {
+            return;
+        }
+    }
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool) :
+        pool_(pool), remaining_(0) {
+}
+
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+        // Exceptions are reported by wait() only
+    }
+}
+
+void TaskGroup::run(ThreadPool::Task task) {
+    ++remaining_;
+    pool_.submit([this, task]() {
+        try {
+            task();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!exception_) {
+                exception_ = std::current_exception();
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--remaining_ == 0) {
+            done_.notify_all();
+        }
+    });
+}
+
+void TaskGroup::wait() {
+    while (remaining_ > 0) {
+        // Help the pool instead of blocking
+        if (pool_.runPending()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait_for(lock, std::chrono::microseconds(100),
+                       [this]() { return remaining_ == 0; });
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (exception_) {
+        std::exception_ptr exception = exception_;
+        exception_ = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,173 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-thread-pool.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Work-stealing thread pool.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <cstddef>
+
+namespace mustache {
+
+/// A work-stealing thread pool.
+///
+/// Each worker has its own queue: tasks submitted by a worker go to its own
+/// queue (and are taken newest first), idle workers steal the oldest tasks
+/// from the other queues. Tasks submitted from other threads are spread
+/// round-robin.
+///
+class ThreadPool {
+  public:
+    // Public part
+
+    typedef std::function<void()> Task;
+
+    /// Construct a pool and starts its workers.
+    ///
+    /// @param threads
+    ///     Number of worker threads (0 means one per hardware thread).
+    ///
+    explicit ThreadPool(unsigned threads = 0);
+
+    /// Waits for pending tasks, then stops the workers.
+    ~ThreadPool();
+
+    /// Number of worker threads.
+    unsigned size() const;
+
+    /// Index of the calling worker thread (from 0 to size() - 1), or size()
+    /// if the caller is not a worker of this pool.
+    unsigned workerIndex() const;
+
+    /// Adds a task. Tasks must not throw (see TaskGroup).
+    void submit(Task task);
+
+    /// Runs a pending task (if any) on the calling thread.
+    /// Threads waiting for tasks call it to help instead of blocking.
+    ///
+    /// @return
+    ///     true if a task has been run.
+    ///
+    bool runPending();
+
+  private:
+    // Private part
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    /// Protects sleeping workers from missing new tasks
+    std::mutex idleMutex_;
+    std::condition_variable idle_;
+
+    /// Tasks submitted but not taken yet
+    std::atomic<std::size_t> pending_;
+
+    /// Queue used for the next task submitted from outside the pool
+    std::atomic<unsigned> next_;
+
+    bool stop_;
+
+    /// Takes a task: first from queue index (newest), then from the others
+    /// (oldest).
+    bool take(unsigned index, Task& task);
+
+    /// Main loop of worker index.
+    void work(unsigned index);
+
+    // Disallow copy constructor and assign operator
+    ThreadPool(const ThreadPool&);
+    void operator=(const ThreadPool&);
+};
+
+/// A group of tasks run on a ThreadPool that can be waited for.
+///
+/// The thread waiting for the group runs pending tasks meanwhile, so groups
+/// can be nested (a task can run a group and wait for it) without
+/// exhausting the workers.
+///
+class TaskGroup {
+  public:
+    // Public part
+
+    explicit TaskGroup(ThreadPool& pool);
+
+    /// Waits for all the tasks of the group.
+    ~TaskGroup();
+
+    /// Adds a task to the group.
+    void run(ThreadPool::Task task);
+
+    /// Waits for all the tasks of the group.
+    ///
+    /// @throws
+    ///     The first exception thrown by a task (if any).
+    ///
+    void wait();
+
+  private:
+    // Private part
+
+    ThreadPool& pool_;
+
+    /// Tasks not completed yet
+    std::atomic<std::size_t> remaining_;
+
+    std::mutex mutex_;
+    std::condition_variable done_;
+
+    /// First exception thrown by a task
+    std::exception_ptr exception_;
+
+    // Disallow copy constructor and assign operator
+    TaskGroup(const TaskGroup&);
+    void operator=(const TaskGroup&);
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
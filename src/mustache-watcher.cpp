@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-watcher.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Hot reload of changed template files (inotify).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mustache-watcher.hpp"
+#include "./mustache-engine.hpp"
+#include "./mustache-exception.hpp"
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <cerrno>
+#endif
+
+namespace mustache {
+
+#ifdef __linux__
+
+static const uint32_t WATCH_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+                                     IN_CREATE | IN_DELETE;
+
+TemplateWatcher::TemplateWatcher(const Engine& engine, Callback changed) :
+        engine_(engine), changed_(changed), fd_(-1) {
+    stopPipe_[0] = stopPipe_[1] = -1;
+    const vector<string> roots = engine_.source().directories();
+    if (roots.empty()) {
+        throw RenderException("Cannot watch templates: the source has no directories");
+    }
+    fd_ = ::inotify_init1(IN_CLOEXEC);
+    if (fd_ < 0 || ::pipe2(stopPipe_, O_CLOEXEC) != 0) {
+        close();
+        throw RenderException("Cannot watch " + roots.front());
+    }
+    try {
+        for (const string& root : roots) {
+            watch(root, "", false);
+        }
+    } catch (...) {
+        close();
+        throw;
+    }
+    thread_ = std::thread(&TemplateWatcher::run, this);
+}
+
+TemplateWatcher::~TemplateWatcher() {
+    // The thread stops on a byte in the pipe or when its write end is
+    // closed (POLLHUP), so it always ends before fd_ and this go away
+    const char stop = 0;
+    while (::write(stopPipe_[1], &stop, 1) < 0 && errno == EINTR) {
+    }
+    ::close(stopPipe_[1]);
+    stopPipe_[1] = -1;
+    thread_.join();
+    close();
+}
+
+void TemplateWatcher::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    for (int i = 0; i < 2; ++i) {
+        if (stopPipe_[i] >= 0) {
+            ::close(stopPipe_[i]);
+        }
+    }
+}
+
+void TemplateWatcher::watch(const string& root, const string& directory, bool created) {
+    const string path = root + directory;
+    const int wd = ::inotify_add_watch(fd_, path.c_str(), WATCH_EVENTS | IN_ONLYDIR);
+    if (wd < 0) {
+        throw RenderException("Cannot watch " + path);
+    }
+    const Directory watched = { root, directory };
+    directories_[wd] = watched;
+
+    DIR* dir = ::opendir(path.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    while (const struct dirent* entry = ::readdir(dir)) {
+        const string name = entry->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        unsigned char type = entry->d_type;
+        if (type == DT_UNKNOWN || type == DT_LNK) {
+            // Not filled by every file system: follow links like the
+            // directory index does
+            struct stat info;
+            if (::stat((path + name).c_str(), &info) != 0) {
+                continue;
+            }
+            type = S_ISDIR(info.st_mode) ? DT_DIR : S_ISREG(info.st_mode) ? DT_REG : DT_UNKNOWN;
+        }
+        if (type == DT_DIR) {
+            watch(root, directory + name + "/", created);
+        } else if (created && type == DT_REG) {
+            // Created before the watch was added
+            handle(directory + name, false);
+        }
+    }
+    ::closedir(dir);
+}
+
+void TemplateWatcher::run() {
+    // Events are aligned as struct inotify_event
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    struct pollfd fds[2] = {
+        { fd_, POLLIN, 0 },
+        { stopPipe_[0], POLLIN, 0 }
+    };
+    for (;;) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (fds[1].revents != 0 || (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) != 0) {
+            return;
+        }
+        const ssize_t size = ::read(fd_, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < size; ) {
+            const struct inotify_event& event =
+                *reinterpret_cast<const struct inotify_event*>(buffer + offset);
+            offset += sizeof(struct inotify_event) + event.len;
+
+            std::map<int, Directory>::const_iterator directory = directories_.find(event.wd);
+            if (event.len == 0 || directory == directories_.end()) {
+                continue;
+            }
+            const string fileName = directory->second.path + event.name;
+            // Files added or removed change the index of the source
+            if (event.mask & (IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM)) {
+                engine_.source().refresh();
+            }
+            if (event.mask & IN_ISDIR) {
+                if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+                    try {
+                        const string root = directory->second.root;
+                        watch(root, fileName + "/", true);
+                    } catch (const RenderException&) {
+                        // Removed meanwhile
+                    }
+                }
+                continue;
+            }
+            if (event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                handle(fileName, false);
+            } else if (event.mask & (IN_DELETE | IN_MOVED_FROM)) {
+                handle(fileName, true);
+            }
+        }
+    }
+}
+
+void TemplateWatcher::handle(const string& fileName, bool removed) {
+    const string extension = "." + engine_.partialExtension();
+    if (fileName.size() <= extension.size() ||
+        fileName.compare(fileName.size() - extension.size(), extension.size(), extension) != 0) {
+        return;
+    }
+    const string name = fileName.substr(0, fileName.size() - extension.size());
+
+    // Only cached templates are compiled again, the others are compiled
+    // when used.
+    if (removed || !engine_.find(name)) {
+        engine_.evict(name);
+    } else {
+        try {
+            engine_.reload(name);
+        } catch (const RenderException&) {
+            // Removed meanwhile
+            engine_.evict(name);
+        }
+    }
+    if (changed_) {
+        changed_(name);
+    }
+}
+
+#else
+
+TemplateWatcher::TemplateWatcher(const Engine& engine, Callback changed) :
+        engine_(engine), changed_(changed), fd_(-1) {
+    stopPipe_[0] = stopPipe_[1] = -1;
+    throw RenderException("Template watching is supported on Linux only");
+}
+
+TemplateWatcher::~TemplateWatcher() {
+}
+
+#endif
+
+}  // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       mustache-watcher.hpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Hot reload of changed template files.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+namespace mustache {
+
+class Engine;
+
+/// Keeps the engine cache up to date with the template files.
+///
+/// A background thread watches with inotify (Linux only) the trees of the
+/// directories of the engine source (see TemplateSource::directories()):
+/// the base path, or every root of a SearchPathSource. When a template file changes its cached version is compiled
+/// again, when it's removed it's evicted. Partials with parameters made
+/// from a changed file are evicted too. Renders pay nothing: no file is
+/// checked when a template is used.
+///
+/// When files are added or removed the source is refreshed first (see
+/// TemplateSource::refresh()): a file added to a search path root before
+/// the one it was taken from replaces the cached template, a file removed
+/// from it falls back to the next root.
+///
+/// Compiled templates refer to their partials by name, so templates
+/// including a changed partial stay valid and use the new version.
+///
+class TemplateWatcher {
+  public:
+    // Public part
+
+    /// Called after a template file has been reloaded or evicted, from the
+    /// watcher thread.
+    typedef std::function<void(const std::string& fileName)> Callback;
+
+    /// Starts watching the directories of the engine source.
+    ///
+    /// @param engine
+    ///     The engine to keep up to date. It must outlive the watcher.
+    /// @param changed
+    ///     Called after each change (optional).
+    ///
+    /// @throws RenderException
+    ///     If a directory cannot be watched, or if the source has no
+    ///     directories (Eg: a MemorySource).
+    ///
+    explicit TemplateWatcher(const Engine& engine, Callback changed = Callback());
+
+    /// Stops watching.
+    ~TemplateWatcher();
+
+  private:
+    // Private part
+
+    const Engine& engine_;
+    Callback changed_;
+
+    /// inotify descriptor
+    int fd_;
+
+    /// Pipe used to wake up and stop the thread
+    int stopPipe_[2];
+
+    /// A watched directory.
+    struct Directory {
+        /// Directory of the source (Eg: "./views/")
+        std::string root;
+
+        /// Path relative to root ("" or ending with '/', Eg: "partials/")
+        std::string path;
+    };
+
+    /// Directories by watch descriptor
+    std::map<int, Directory> directories_;
+
+    std::thread thread_;
+
+    /// Adds watches to a directory (relative to root, "" or ending with
+    /// '/') and to its subdirectories. If the directory has just been
+    /// created, files already there are handled as changed.
+    void watch(const std::string& root, const std::string& directory, bool created);
+
+    /// Main loop of the watcher thread.
+    void run();
+
+    /// Handles a change of fileName (relative to its root, extension
+    /// included).
+    void handle(const std::string& fileName, bool removed);
+
+    /// Releases the descriptors.
+    void close();
+
+    // Disallow copy constructor and assign operator
+    TemplateWatcher(const TemplateWatcher&);
+    void operator=(const TemplateWatcher&);
+};
+
+} // namespace mustache
+
+////////////////////////////////////////////////////////////////////////////////
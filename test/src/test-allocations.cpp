@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       test-allocations.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache test suite (allocations of steady-state renders).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+using std::string;
+#include <utility>
+#include <vector>
+using std::vector;
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include <catch2/catch.hpp>
+
+#include "../../src/mustache-light.hpp"
+using mustache::Engine;
+using mustache::Renderer;
+using mustache::RenderStats;
+using mustache::TemplatePtr;
+
+// Counts the allocations of every thread of the test suite
+MUSTACHE_COUNT_ALLOCATIONS()
+
+TEST_CASE("Allocations") {
+    // (view, context) of the fixtures that render without errors
+    const vector<std::pair<string, string> > fixtures = {
+        { "basic/simple-html", "basic/empty" },
+        { "basic/two-equal-variables", "basic/two-equal-variables" },
+        { "basic/comments", "basic/empty" },
+        { "logic/logic", "logic/logic" },
+        { "logic/logic", "logic/logic-negated" },
+        { "logic/nested", "logic/nested" },
+        { "logic/nested", "logic/nested-negated" },
+        { "partials/simple", "partials/simple" },
+        { "partials/nested", "partials/nested" },
+        { "partials/with-variables", "partials/with-variables" },
+        { "partials/multiple-partials-with-variables", "partials/multiple-partials-with-variables" },
+        { "partials/partial-inside-hidden-block", "partials/partial-inside-hidden-block" },
+        { "sections/sections-with-data", "sections/sections-with-data" },
+        { "sections/list", "sections/list" },
+        { "sections/list-special-variables", "sections/list-special-variables" },
+        { "sections/list-with-indexes", "sections/list-with-indexes" },
+        { "sections/list-with-missing-index", "sections/list-with-missing-index" },
+        { "sections/sections-exists-test", "sections/sections-exists-test" },
+        { "sections/sections-exists-test-vs-value-test", "sections/sections-exists-test-array" },
+        { "templates/basic-template", "templates/basic-template" }
+    };
+    const Engine engine("./test/fixtures/");
+
+    SECTION("Steady state") {
+        for (const std::pair<string, string>& fixture : fixtures) {
+            const TemplatePtr view = engine.load(fixture.first);
+            const json context = json::parse(engine.fileRead(fixture.second, "json"));
+            Renderer renderer(engine);
+            RenderStats stats;
+            renderer.setStats(&stats);
+            mustache::Metrics metrics;
+            renderer.setMetrics(&metrics, fixture.first);
+
+            // Warm up: partials are compiled, buffers grow to their size
+            REQUIRE(renderer.render(*view, context));
+            REQUIRE(renderer.render(*view, context));
+
+            // Steady state: no allocation at all
+            std::size_t allocations = 0;
+            for (int i = 0; i < 10; ++i) {
+                REQUIRE(renderer.render(*view, context));
+                allocations += stats.allocations;
+            }
+            INFO(fixture.first << " with context " << fixture.second);
+            REQUIRE(allocations == 0);
+        }
+    }
+
+    SECTION("Counting") {
+        REQUIRE(mustache::allocationsCounted());
+
+        // The first render of a new renderer grows its buffers
+        const TemplatePtr view = engine.load("partials/with-variables");
+        const json context = json::parse(engine.fileRead("partials/with-variables", "json"));
+        Renderer renderer(engine);
+        RenderStats stats;
+        renderer.setStats(&stats);
+        REQUIRE(renderer.render(*view, context));
+        REQUIRE(stats.allocations > 0);
+        REQUIRE(stats.allocatedBytes >= renderer.output().size());
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,187 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       test-async.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache test suite (asynchronous partial loading).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include <catch2/catch.hpp>
+
+#include "../../src/mustache-light.hpp"
+using mustache::AsyncLoader;
+using mustache::Engine;
+using mustache::Renderer;
+using mustache::TemplatePtr;
+using mustache::ThreadPool;
+using mustache::ThreadPoolLoader;
+
+// Queues the reads, like an event loop: they complete when run() is called.
+class QueueLoader : public AsyncLoader {
+  public:
+    explicit QueueLoader(const Engine& engine) : engine_(engine) {
+    }
+
+    void read(const string& fileName, Callback done) override {
+        reads_.push_back(std::make_pair(fileName, done));
+        ++total;
+    }
+
+    // Completes the queued reads.
+    void run() {
+        vector<std::pair<string, Callback> > reads;
+        reads.swap(reads_);
+        for (std::size_t i = 0; i < reads.size(); ++i) {
+            try {
+                reads[i].second(engine_.fileRead(reads[i].first), "");
+            } catch (const std::exception& err) {
+                reads[i].second("", err.what());
+            }
+        }
+    }
+
+    bool empty() const {
+        return reads_.empty();
+    }
+
+    unsigned total = 0;
+
+  private:
+    const Engine& engine_;
+    vector<std::pair<string, Callback> > reads_;
+};
+
+TEST_CASE("Asynchronous partial loading") {
+    const Engine blocking("./test/fixtures/");
+    const Engine engine("./test/fixtures/");
+    Renderer expected(blocking);
+    Renderer renderer(engine);
+    QueueLoader loader(engine);
+
+    SECTION("The render is suspended until partials are read") {
+        const string name = "partials/nested";
+        const json context = json::parse(engine.fileRead(name, "json"));
+        REQUIRE(expected.render(*blocking.load(name), context));
+
+        unsigned calls = 0;
+        bool result = false;
+        renderer.renderAsync(engine.compile(engine.fileRead(name)), context, loader,
+                             [&](bool ok) { ++calls; result = ok; });
+        // Partials nested inside missing partials are found later
+        unsigned suspensions = 0;
+        while (!loader.empty()) {
+            REQUIRE(calls == 0);
+            loader.run();
+            ++suspensions;
+        }
+        REQUIRE(calls == 1);
+        REQUIRE(result);
+        REQUIRE(suspensions == 3);
+        REQUIRE(loader.total == 5);
+        REQUIRE(renderer.output() == expected.output());
+
+        // Everything is cached now: no suspension
+        renderer.renderAsync(engine.compile(engine.fileRead(name)), context, loader,
+                             [&](bool ok) { ++calls; result = ok; });
+        REQUIRE(calls == 2);
+        REQUIRE(loader.empty());
+        REQUIRE(renderer.output() == expected.output());
+    }
+
+    SECTION("Partials with parameters") {
+        const string name = "partials/multiple-partials-with-variables";
+        const json context = json::parse(engine.fileRead(name, "json"));
+        REQUIRE(expected.render(*blocking.load(name), context));
+
+        bool result = false;
+        renderer.renderAsync(engine.compile(engine.fileRead(name)), context, loader,
+                             [&](bool ok) { result = ok; });
+        while (!loader.empty()) {
+            loader.run();
+        }
+        REQUIRE(result);
+        REQUIRE(loader.total == 1);
+        REQUIRE(renderer.output() == expected.output());
+    }
+
+    SECTION("Read errors are render errors") {
+        const string name = "templates/basic-template";
+        const json context = json::parse(engine.fileRead("templates/not-existing-template", "json"));
+        REQUIRE_FALSE(expected.render(*blocking.load(name), context));
+
+        bool result = true;
+        renderer.renderAsync(engine.compile(engine.fileRead(name)), context, loader,
+                             [&](bool ok) { result = ok; });
+        while (!loader.empty()) {
+            loader.run();
+        }
+        REQUIRE_FALSE(result);
+        REQUIRE(renderer.error() == expected.error());
+        REQUIRE(renderer.error() == "Cannot open file: ./test/fixtures/do-not-exists.mustache");
+        REQUIRE(renderer.output() == expected.output());
+    }
+
+    SECTION("Reads on a thread pool") {
+        ThreadPool pool(2);
+        ThreadPoolLoader poolLoader(engine, pool);
+        const string name = "partials/nested";
+        const json context = json::parse(engine.fileRead(name, "json"));
+        REQUIRE(expected.render(*blocking.load(name), context));
+
+        std::mutex mutex;
+        std::condition_variable completed;
+        bool done = false;
+        bool result = false;
+        renderer.renderAsync(engine.compile(engine.fileRead(name)), context, poolLoader,
+                             [&](bool ok) {
+                                 std::lock_guard<std::mutex> lock(mutex);
+                                 result = ok;
+                                 done = true;
+                                 completed.notify_all();
+                             });
+        std::unique_lock<std::mutex> lock(mutex);
+        completed.wait(lock, [&]() { return done; });
+        REQUIRE(result);
+        REQUIRE(renderer.output() == expected.output());
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
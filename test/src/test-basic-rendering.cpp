@@ -33,6 +33,8 @@
 ///
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <clocale>
+#include <cstdio>
 #include <iostream>
 #include <string>
 using std::string;
@@ -111,4 +113,80 @@ TEST_CASE("Basic rendering") {
     }
 }
 
+TEST_CASE("Scalar rendering") {
+    Mustache m("./test/fixtures/");
+
+    SECTION("Render numbers and booleans") {
+        string expected = "42 -7 18446744073709551615 1.5 3.0 true []";
+        string view = "{{ int }} {{ negative }} {{ unsigned }} {{ float }} "
+                "{{ integral-float }} {{ yes }} [{{ no }}]";
+        string context = "{ \"int\": 42, \"negative\": -7, "
+                "\"unsigned\": 18446744073709551615, \"float\": 1.5, "
+                "\"integral-float\": 3.0, \"yes\": true, \"no\": false }";
+        string res = m.render(view, context);
+        REQUIRE(res == expected);
+        REQUIRE(m.error().empty());
+    }
+
+    SECTION("Render numbers with fixed decimals") {
+        string expected = "1.50 -7.000 42 0.1";
+        string view = "{{ float:.2 }} {{ negative :.3 }} {{ int:.0 }} {{{ small:.1 }}}";
+        string context = "{ \"float\": 1.5, \"negative\": -7, \"int\": 42, "
+                "\"small\": 0.1234 }";
+        string res = m.render(view, context);
+        REQUIRE(res == expected);
+        REQUIRE(m.error().empty());
+    }
+
+    SECTION("Fixed decimals are rounded like printf") {
+        const double values[] = { 0.125, 0.375, 1.005, 2.5, 3.5, -0.001,
+                -2.675, 0.1, 123456.789, 1e-320, 4503599627370497.0, 1e300 };
+        const int decimals[] = { 0, 1, 2, 3, 20 };
+        for (double value : values) {
+            for (int n : decimals) {
+                char expected[400];
+                std::snprintf(expected, sizeof(expected), "%.*f", n, value);
+                string view = "{{ value:." + std::to_string(n) + " }}";
+                string res = m.render(view, nlohmann::json{{"value", value}});
+                CAPTURE(value, n);
+                REQUIRE(res == expected);
+            }
+        }
+    }
+
+    SECTION("Fixed decimals ignore the C locale") {
+        const char* locales[] = { "it_IT.UTF-8", "de_DE.UTF-8", "fr_FR.UTF-8",
+                "it_IT", "de_DE", "fr_FR" };
+        bool found = false;
+        for (const char* locale : locales) {
+            if (std::setlocale(LC_ALL, locale) != nullptr
+                    && *std::localeconv()->decimal_point == ',') {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            std::setlocale(LC_ALL, "C");
+            WARN("No locale with a decimal comma is installed");
+            return;
+        }
+        string res = m.render("{{ price:.2 }} {{ big:.1 }} {{ price }}",
+                "{ \"price\": 1.5, \"big\": 1e17 }"_json);
+        std::setlocale(LC_ALL, "C");
+        REQUIRE(res == "1.50 100000000000000000.0 1.5");
+    }
+
+    SECTION("Number format is ignored for strings") {
+        string res = m.render("{{ text:.2 }}", "{ \"text\": \"<b>\" }"_json);
+        REQUIRE(res == "&lt;b&gt;");
+        REQUIRE(m.error().empty());
+    }
+
+    SECTION("Invalid number format") {
+        string res = m.render("[{{ float:2 }}]", "{ \"float\": 1.5 }"_json);
+        REQUIRE(res == "[");
+        REQUIRE(m.error() == "Invalid number format in 'float:2'");
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       test-batch.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache test suite (batch rendering and thread pool).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <atomic>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include <catch2/catch.hpp>
+
+#include "../../src/mustache-light.hpp"
+using mustache::Engine;
+using mustache::EngineOptions;
+using mustache::Renderer;
+using mustache::ThreadPool;
+using mustache::BatchRenderer;
+using mustache::TaskGroup;
+using mustache::TemplatePtr;
+
+TEST_CASE("Batch rendering") {
+    const Engine engine("./test/fixtures/");
+    const TemplatePtr view = engine.load("templates/basic-template");
+    const json good = json::parse(engine.fileRead("templates/basic-template", "json"));
+    const json bad = json::parse(engine.fileRead("templates/not-existing-template", "json"));
+
+    // Every 10th context refers to a missing template
+    vector<json> contexts;
+    for (unsigned i = 0; i < 1000; ++i) {
+        json context = (i % 10 == 9) ? bad : good;
+        context["title"] = "Page " + std::to_string(i);
+        contexts.push_back(context);
+    }
+
+    SECTION("Same outputs and errors of sequential renders") {
+        vector<string> outputs;
+        vector<string> errors = engine.renderBatch(*view, contexts, outputs, 4);
+        REQUIRE(outputs.size() == contexts.size());
+        REQUIRE(errors.size() == contexts.size());
+
+        Renderer renderer(engine);
+        unsigned mismatches = 0;
+        for (std::size_t i = 0; i < contexts.size(); ++i) {
+            renderer.render(*view, contexts.at(i));
+            if (outputs.at(i) != renderer.output() || errors.at(i) != renderer.error()) {
+                ++mismatches;
+            }
+        }
+        REQUIRE(mismatches == 0);
+        REQUIRE(errors.at(0).empty());
+        REQUIRE(errors.at(9) == "Cannot open file: ./test/fixtures/do-not-exists.mustache");
+    }
+
+    SECTION("Pool reused by many batches") {
+        ThreadPool pool(3);
+        vector<string> outputs;
+        for (unsigned batch = 0; batch < 5; ++batch) {
+            vector<string> errors = engine.renderBatch(*view, contexts, outputs, pool);
+            REQUIRE(outputs.size() == contexts.size());
+            REQUIRE(outputs.at(123).find("<title>Page 123</title>") != string::npos);
+            REQUIRE(errors.at(19).size() > 0);
+        }
+    }
+
+    SECTION("Renderers kept across batches") {
+        ThreadPool pool(3);
+        BatchRenderer batch(engine, pool);
+        REQUIRE(batch.renderers() == 0);
+        vector<string> outputs;
+        for (unsigned i = 0; i < 5; ++i) {
+            vector<json> chunk(contexts.begin() + i * 200, contexts.begin() + (i + 1) * 200);
+            vector<string> errors = batch.render(*view, chunk, outputs);
+            REQUIRE(outputs.size() == chunk.size());
+            REQUIRE(outputs.at(23).find("<title>Page " + std::to_string(i * 200 + 23) + "</title>")
+                    != string::npos);
+            REQUIRE(errors.at(19).size() > 0);
+            REQUIRE(batch.renderers() > 0);
+            REQUIRE(batch.renderers() <= pool.size() + 1);
+        }
+    }
+
+    SECTION("Empty batch") {
+        vector<json> none;
+        vector<string> outputs(3);
+        vector<string> errors = engine.renderBatch(*view, none, outputs);
+        REQUIRE(outputs.empty());
+        REQUIRE(errors.empty());
+    }
+}
+
+TEST_CASE("Batch rendering on the engine pool") {
+    // Renders waiting for their partials run other batch tasks meanwhile
+    EngineOptions options;
+    options.threads = 2;
+    options.parallelPartials = true;
+    const Engine engine("./test/fixtures/", options);
+    const TemplatePtr view = engine.load("partials/multiple-partials-with-variables");
+    const json base = json::parse(engine.fileRead("partials/multiple-partials-with-variables", "json"));
+    vector<json> contexts;
+    for (unsigned i = 0; i < 4000; ++i) {
+        json context = base;
+        context["title"] = "Users " + std::to_string(i);
+        contexts.push_back(context);
+    }
+
+    Renderer renderer(engine);
+    vector<string> expected;
+    for (const json& context : contexts) {
+        renderer.render(*view, context);
+        expected.push_back(renderer.output());
+    }
+
+    BatchRenderer batch(engine, *engine.pool());
+    vector<string> outputs;
+    unsigned mismatches = 0;
+    for (unsigned i = 0; i < 10; ++i) {
+        const vector<string> errors = batch.render(*view, contexts, outputs);
+        for (std::size_t j = 0; j < contexts.size(); ++j) {
+            if (outputs.at(j) != expected.at(j) || !errors.at(j).empty()) {
+                ++mismatches;
+            }
+        }
+    }
+    REQUIRE(mismatches == 0);
+}
+
+TEST_CASE("Thread pool") {
+    ThreadPool pool(2);
+
+    SECTION("Nested groups do not exhaust workers") {
+        std::atomic<unsigned> count(0);
+        TaskGroup outer(pool);
+        for (unsigned i = 0; i < 8; ++i) {
+            outer.run([&pool, &count]() {
+                TaskGroup inner(pool);
+                for (unsigned j = 0; j < 8; ++j) {
+                    inner.run([&count]() { ++count; });
+                }
+                inner.wait();
+            });
+        }
+        outer.wait();
+        REQUIRE(count == 64);
+    }
+
+    SECTION("Exceptions are reported by wait") {
+        TaskGroup group(pool);
+        group.run([]() { throw std::runtime_error("task failed"); });
+        group.run([]() {});
+        REQUIRE_THROWS_WITH(group.wait(), "task failed");
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -35,6 +35,8 @@
 
 #include <string>
 using std::string;
+#include <vector>
+using std::vector;
 
 #include <catch2/catch.hpp>
 
@@ -98,6 +100,39 @@ TEST_CASE("Rendering with errors") {
         REQUIRE(res == html);
         REQUIRE(m.error() == "Missing {{/");
     }
+
+    SECTION("Invalid identifiers") {
+        // Checked once when the template is compiled, raised when the
+        // tag is rendered
+        string res = m.render("a{{ b c }}d", string("{}"));
+        REQUIRE(res == "a");
+        REQUIRE(m.error().find("Invalid identifier 'b c'") == 0);
+
+        res = m.render("a{{# off }}{{ b c }}{{/ off }}d", string("{}"));
+        REQUIRE(m.error().empty());
+        REQUIRE(res == "ad");
+
+        m.render("{{ items[ }}", string("{\"items\": [1]}"));
+        REQUIRE(m.error() == "Missing ] in array selection");
+
+        const mustache::Template view("{{ items[1]:.2 }}{{> user | Name='Mario' }}");
+        const mustache::Template::Tokens tokens = view.tokens();
+        vector<const mustache::Template::Tag*> tags;
+        for (std::size_t i = 0; i < tokens.size(); ++i) {
+            if (!view.tag(i).name.empty()) {
+                tags.push_back(&view.tag(i));
+            }
+        }
+        REQUIRE(tags.size() == 2);
+        REQUIRE(tags[0]->name == "items[1]");
+        REQUIRE(tags[0]->key == "items");
+        REQUIRE(tags[0]->selection == mustache::Template::Tag::Selection::Index);
+        REQUIRE(tags[0]->index == 1);
+        REQUIRE(tags[0]->decimals == 2);
+        REQUIRE(tags[1]->name == "user");
+        REQUIRE(tags[1]->parameters == vector<string>{"Name='Mario'"});
+        REQUIRE(tags[1]->error.empty());
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -43,6 +43,7 @@ using nlohmann::json;
 
 #include "../../src/mustache-light.hpp"
 using mustache::Mustache;
+using mustache::Escape;
 
 TEST_CASE("Escape") {
     Mustache m("./test/fixtures/");
@@ -115,4 +116,71 @@ TEST_CASE("Escape") {
     }
 }
 
+TEST_CASE("Escape policies") {
+    json context;
+    context["name"] = "<a href=\"x\">Tom & Jerry</a>, 100%\n";
+
+    SECTION("HTML is the default policy") {
+        Mustache m("./test/fixtures/", "mustache", Escape::Html);
+        string expected = "&lt;a href=&quot;x&quot;&gt;Tom &amp; Jerry&lt;/a&gt;, 100&percnt;";
+        string res = m.render("{{ name }}", context);
+        REQUIRE(res == expected);
+        REQUIRE(m.error().empty());
+    }
+
+    SECTION("HTML attribute") {
+        Mustache m("./test/fixtures/", "mustache", Escape::HtmlAttribute);
+        string expected = "&#x3C;a&#x20;href&#x3D;&#x22;x&#x22;&#x3E;Tom&#x20;&#x26;&#x20;"
+                "Jerry&#x3C;&#x2F;a&#x3E;&#x2C;&#x20;100&#x25;&#x0A;";
+        string res = m.render("{{ name }}", context);
+        REQUIRE(res == expected);
+        REQUIRE(m.error().empty());
+    }
+
+    SECTION("JSON string") {
+        Mustache m("./test/fixtures/", "mustache", Escape::Json);
+        string expected = "{\"name\": \"<a href=\\\"x\\\">Tom & Jerry</a>, 100%\\n\"}";
+        string res = m.render("{\"name\": \"{{ name }}\"}", context);
+        REQUIRE(res == expected);
+        REQUIRE(json::parse(res)["name"] == context["name"]);
+        REQUIRE(m.error().empty());
+    }
+
+    SECTION("CSV field") {
+        Mustache m("./test/fixtures/", "mustache", Escape::Csv);
+        json row;
+        row["plain"] = "Tom";
+        row["comma"] = "Tom, Jerry";
+        row["quote"] = "Tom \"the cat\"";
+        string expected = "Tom,\"Tom, Jerry\",\"Tom \"\"the cat\"\"\"";
+        string res = m.render("{{ plain }},{{ comma }},{{ quote }}", row);
+        REQUIRE(res == expected);
+        REQUIRE(m.error().empty());
+    }
+
+    SECTION("URL component") {
+        Mustache m("./test/fixtures/", "mustache", Escape::Url);
+        json query;
+        query["q"] = "tom & jerry/àè~";
+        string expected = "/search?q=tom%20%26%20jerry%2F%C3%A0%C3%A8~";
+        string res = m.render("/search?q={{ q }}", query);
+        REQUIRE(res == expected);
+        REQUIRE(m.error().empty());
+    }
+
+    SECTION("No escape") {
+        Mustache m("./test/fixtures/", "mustache", Escape::None);
+        string res = m.render("{{ name }}", context);
+        REQUIRE(res == context["name"].get<string>());
+        REQUIRE(m.error().empty());
+    }
+
+    SECTION("Unescaped variables ignore the policy") {
+        Mustache m("./test/fixtures/", "mustache", Escape::Url);
+        string res = m.render("{{{ name }}}", context);
+        REQUIRE(res == context["name"].get<string>());
+        REQUIRE(m.error().empty());
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
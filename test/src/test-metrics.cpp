@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       test-metrics.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache test suite (render metrics).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+using std::string;
+#include <thread>
+#include <vector>
+using std::vector;
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include <catch2/catch.hpp>
+
+#include "../../src/mustache-light.hpp"
+using mustache::Engine;
+using mustache::Metrics;
+using mustache::MetricsSnapshot;
+using mustache::Renderer;
+using mustache::RenderResult;
+using mustache::RenderStats;
+using mustache::TemplateMetrics;
+using mustache::TemplatePtr;
+
+TEST_CASE("Render metrics") {
+    const Engine engine("./test/fixtures/");
+    const TemplatePtr page = engine.compile("{{ title }}{{> partials/common/doctype }}");
+    Metrics metrics;
+
+    SECTION("Results and counters") {
+        Renderer renderer(engine);
+        renderer.setMetrics(&metrics, "page");
+        REQUIRE(renderer.render(*page, json({ { "title", "T" } })));
+        REQUIRE(renderer.render(*page, string("{\"title\": \"T\"}")));
+        REQUIRE_FALSE(renderer.render(*page, string("{ not json")));
+        REQUIRE_FALSE(renderer.render(*engine.compile("{{> do-not-exists }}"), json::object()));
+        renderer.setMetrics(&metrics, "broken");
+        REQUIRE_FALSE(renderer.render(*engine.compile("{{# a }}"), json::object()));
+
+        const MetricsSnapshot snapshot = metrics.snapshot();
+        REQUIRE(snapshot.templates.size() == 2);
+        const TemplateMetrics& view = snapshot.templates.at("page");
+        REQUIRE(view.renders() == 4);
+        REQUIRE(view.count(RenderResult::Ok) == 2);
+        REQUIRE(view.count(RenderResult::ContextError) == 1);
+        REQUIRE(view.count(RenderResult::PartialError) == 1);
+        REQUIRE(snapshot.templates.at("broken").count(RenderResult::TemplateError) == 1);
+        REQUIRE(view.partialMisses == 1);
+        REQUIRE(view.partialHits == 1);
+        REQUIRE(view.cacheHitRate() == Approx(0.5));
+        REQUIRE(view.lookups == 2);
+
+        // Every render is in a latency bucket
+        std::size_t latencies = 0;
+        for (std::size_t i = 0; i < mustache::LATENCY_BUCKETS; ++i) {
+            latencies += view.latency[i];
+        }
+        REQUIRE(latencies == 4);
+        REQUIRE(view.latencySum.count() > 0);
+        REQUIRE(snapshot.total().renders() == 5);
+
+        // Failed renders emit nothing
+        Renderer plain(engine);
+        REQUIRE(plain.render(*page, json({ { "title", "T" } })));
+        REQUIRE(view.bytesEmitted == 2 * plain.output().size());
+
+        metrics.clear();
+        REQUIRE(metrics.snapshot().templates.empty());
+    }
+
+    SECTION("Statistics of the renderer") {
+        Renderer renderer(engine);
+        RenderStats stats;
+        renderer.setMetrics(&metrics, "page");
+        renderer.setStats(&stats);
+        REQUIRE(renderer.render(*page, json({ { "title", "T" } })));
+        REQUIRE(stats.lookups == 1);
+        renderer.setStats(nullptr);
+        REQUIRE(renderer.render(*page, json({ { "title", "T" } })));
+        REQUIRE(stats.lookups == 1);
+        REQUIRE(metrics.snapshot().templates.at("page").lookups == 2);
+
+        // Disabled
+        renderer.setMetrics(nullptr);
+        REQUIRE(renderer.render(*page, json({ { "title", "T" } })));
+        REQUIRE(metrics.snapshot().templates.at("page").renders() == 2);
+    }
+
+    SECTION("Threads") {
+        vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.push_back(std::thread([&engine, &page, &metrics, t]() {
+                Renderer renderer(engine);
+                renderer.setMetrics(&metrics, t % 2 == 0 ? "even" : "odd");
+                for (int i = 0; i < 100; ++i) {
+                    renderer.render(*page, json({ { "title", i } }));
+                }
+            }));
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        const MetricsSnapshot snapshot = metrics.snapshot();
+        REQUIRE(snapshot.templates.at("even").count(RenderResult::Ok) == 400);
+        REQUIRE(snapshot.templates.at("odd").count(RenderResult::Ok) == 400);
+        REQUIRE(snapshot.total().lookups == 800);
+    }
+
+    SECTION("Prometheus") {
+        Renderer renderer(engine);
+        renderer.setMetrics(&metrics, "a \"quoted\" page");
+        REQUIRE(renderer.render(*page, json({ { "title", "T" } })));
+        REQUIRE(renderer.render(*page, json({ { "title", "T" } })));
+
+        // The profile has a name of its own
+        mustache::Profile profile;
+        renderer.setProfile(&profile);
+        REQUIRE(renderer.render(*page, json({ { "title", "T" } })));
+        renderer.setProfile(nullptr);
+
+        const string text = metrics.prometheus("test");
+        REQUIRE(text.find("# TYPE test_renders_total counter\n") != string::npos);
+        REQUIRE(text.find("test_renders_total{template=\"a \\\"quoted\\\" page\",result=\"ok\"} 3\n") !=
+                string::npos);
+        REQUIRE(text.find("test_renders_total{template=\"a \\\"quoted\\\" page\",result=\"partial_error\"} 0\n") !=
+                string::npos);
+        REQUIRE(text.find("# TYPE test_render_duration_seconds histogram\n") != string::npos);
+        REQUIRE(text.find("test_render_duration_seconds_bucket{template=\"a \\\"quoted\\\" page\",le=\"+Inf\"} 3\n") !=
+                string::npos);
+        REQUIRE(text.find("test_render_duration_seconds_count{template=\"a \\\"quoted\\\" page\"} 3\n") !=
+                string::npos);
+        REQUIRE(text.find("test_partial_cache_hits_total{template=\"a \\\"quoted\\\" page\"} 2\n") !=
+                string::npos);
+        REQUIRE(text.find("test_output_bytes_total{template=\"a \\\"quoted\\\" page\"} " +
+                          std::to_string(3 * renderer.output().size()) + "\n") != string::npos);
+        REQUIRE(text.find("template=\"(view)\"") == string::npos);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
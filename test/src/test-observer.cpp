@@ -0,0 +1,205 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       test-observer.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache test suite (render observers).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <memory>
+#include <sstream>
+#include <utility>
+#include <algorithm>
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include <catch2/catch.hpp>
+
+#include "../../src/mustache-light.hpp"
+using mustache::AsyncLoader;
+using mustache::Engine;
+using mustache::EngineOptions;
+using mustache::Renderer;
+using mustache::RenderObserver;
+using mustache::StreamObserver;
+using mustache::Template;
+using mustache::TemplatePtr;
+using mustache::TokenKind;
+using mustache::tokenKindText;
+
+// Records events as strings
+class Recorder : public RenderObserver {
+  public:
+    void renderBegin(const Template&) override {
+        events.push_back("begin");
+    }
+    void renderEnd(const Template&, bool ok, std::size_t bytes) override {
+        events.push_back(string("end ") + (ok ? "ok " : "failed ") + std::to_string(bytes));
+    }
+    void partialResolve(const string& tag, const string& fileName) override {
+        events.push_back("resolve " + tag + " -> " + fileName);
+    }
+    void partialLoad(const string& fileName, bool cached, std::chrono::nanoseconds) override {
+        events.push_back("load " + fileName + (cached ? " cached" : " read"));
+    }
+    void sectionEnter(TokenKind kind, const string& name) override {
+        events.push_back("enter " + tokenKindText(kind) + " " + name);
+    }
+    void sectionExit(TokenKind kind, const string& name, std::size_t iterations) override {
+        events.push_back("exit " + tokenKindText(kind) + " " + name + " " + std::to_string(iterations));
+    }
+    void error(const string& message) override {
+        events.push_back("error " + message);
+    }
+
+    vector<string> events;
+};
+
+// Queues the reads: they complete (and resume the render) in run()
+class PendingReads : public AsyncLoader {
+  public:
+    explicit PendingReads(const Engine& engine) : engine_(engine) {
+    }
+
+    void read(const string& fileName, Callback done) override {
+        reads_.push_back(std::make_pair(fileName, done));
+    }
+
+    void run() {
+        while (!reads_.empty()) {
+            vector<std::pair<string, Callback> > reads;
+            reads.swap(reads_);
+            for (std::size_t i = 0; i < reads.size(); ++i) {
+                reads[i].second(engine_.fileRead(reads[i].first), "");
+            }
+        }
+    }
+
+  private:
+    const Engine& engine_;
+    vector<std::pair<string, Callback> > reads_;
+};
+
+TEST_CASE("Render observers") {
+    const json context = {
+        { "items", { 1, 2, 3 } },
+        { "off", false },
+        { "page", "partials/common/doctype" }
+    };
+
+    SECTION("Lifecycle events") {
+        const Engine engine("./test/fixtures/");
+        const TemplatePtr view = engine.compile(
+            "{{# items }}-{{/ items }}{{^ off }}{{< page }}{{/ off }}"
+            "{{= off }}{{> partials/common/text }}{{/ off }}{{> partials/common/doctype }}");
+        Renderer renderer(engine);
+        Recorder recorder;
+        renderer.setObserver(&recorder);
+
+        REQUIRE(renderer.render(*view, context));
+        const vector<string> expected = {
+            "begin",
+            "enter {{# items",
+            "exit {{# items 3",
+            "enter {{^ off",
+            "resolve page -> partials/common/doctype",
+            "load partials/common/doctype read",
+            "exit {{^ off 1",
+            "enter {{= off",
+            "exit {{= off 0",
+            "resolve partials/common/doctype -> partials/common/doctype",
+            "load partials/common/doctype cached",
+            "end ok " + std::to_string(renderer.output().size())
+        };
+        REQUIRE(recorder.events == expected);
+
+        // Errors come before the end of the render
+        recorder.events.clear();
+        REQUIRE_FALSE(renderer.render(*engine.compile("{{> do-not-exists }}"), context));
+        REQUIRE(recorder.events.size() == 4);
+        REQUIRE(recorder.events.at(2).find("error Cannot open file: ") == 0);
+        REQUIRE(recorder.events.at(3) == "end failed 0");
+
+        // Disabled
+        recorder.events.clear();
+        renderer.setObserver(nullptr);
+        REQUIRE(renderer.render(*view, context));
+        REQUIRE(recorder.events.empty());
+    }
+
+    SECTION("Suspended asynchronous renders") {
+        const Engine engine("./test/fixtures/");
+        const string name = "partials/nested";
+        const json nested = json::parse(engine.fileRead(name, "json"));
+        Renderer renderer(engine);
+        Recorder recorder;
+        renderer.setObserver(&recorder);
+        PendingReads loader(engine);
+
+        bool done = false;
+        renderer.renderAsync(engine.compile(engine.fileRead(name)), nested, loader,
+                             [&](bool ok) { done = ok; });
+        loader.run();
+        REQUIRE(done);
+
+        // Suspended passes neither begin nor end a render
+        REQUIRE(std::count(recorder.events.begin(), recorder.events.end(), "begin") == 1);
+        REQUIRE(recorder.events.front() == "begin");
+        REQUIRE(recorder.events.back() == "end ok " + std::to_string(renderer.output().size()));
+        REQUIRE(std::count_if(recorder.events.begin(), recorder.events.end(),
+                              [](const string& event) { return event.find("end ") == 0; }) == 1);
+
+        // A blocking render afterwards is reported as usual
+        recorder.events.clear();
+        REQUIRE(renderer.render(*engine.load(name), nested));
+        REQUIRE(recorder.events.front() == "begin");
+    }
+
+    SECTION("Engine observer") {
+        std::ostringstream out;
+        EngineOptions options;
+        options.observer = std::make_shared<StreamObserver>(out);
+        const Engine engine("./test/fixtures/", options);
+        Renderer renderer(engine);
+
+        REQUIRE(renderer.render(*engine.compile("{{# items }}{{/ items }}"), context));
+        REQUIRE(out.str() == "render begin: 9 tokens\n"
+                             "section enter: {{# items }}\n"
+                             "section exit: {{# items }}, 3 iterations\n"
+                             "render end: ok, 0 bytes\n");
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,231 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       test-parallel.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache test suite (parallel rendering of a single template).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include <catch2/catch.hpp>
+
+#include "../../src/mustache-light.hpp"
+using mustache::Mustache;
+using mustache::EngineOptions;
+using mustache::Renderer;
+using mustache::RenderObserver;
+using mustache::TokenKind;
+
+TEST_CASE("Parallel array sections") {
+    EngineOptions options;
+    options.threads = 4;
+    options.parallelSectionThreshold = 100;
+    Mustache parallel("./test/fixtures/", options);
+    Mustache sequential("./test/fixtures/");
+
+    json context;
+    for (unsigned i = 0; i < 5000; ++i) {
+        json row;
+        row["name"] = "row <" + std::to_string(i) + ">";
+        row["values"] = { i, i + 1, i + 2 };
+        row["page"] = "partials/common/doctype";
+        context["rows"].push_back(row);
+    }
+
+    SECTION("Same output of a sequential render") {
+        string view = "{{# rows }}{{= @first }}[first]{{/ @first }}"
+                "{{ @index }}:{{ name }}={{# values }}{{ @index }}.{{/ values }};"
+                "{{/ rows }}end";
+        string expected = sequential.render(view, context);
+        REQUIRE(sequential.error().empty());
+        REQUIRE(expected.find("[first]0:row &lt;0&gt;=0.1.2.;1:") == 0);
+
+        string res = parallel.render(view, context);
+        REQUIRE(parallel.error().empty());
+        REQUIRE(res == expected);
+    }
+
+    SECTION("Small arrays are rendered sequentially") {
+        string res = parallel.render("{{# values }}{{ @index }}{{/ values }}",
+                                     context["rows"][0]);
+        REQUIRE(parallel.error().empty());
+        REQUIRE(res == "012");
+    }
+
+    SECTION("Partials inside parallel sections") {
+        string view = "{{# rows }}{{> partials/common/text }}{{/ rows }}";
+        context["rows"][10]["text"] = "tenth";
+        string expected = sequential.render(view, context);
+        string res = parallel.render(view, context);
+        REQUIRE(parallel.error().empty());
+        REQUIRE(res == expected);
+    }
+
+    SECTION("Errors stop the render at the same point") {
+        string view = "{{# rows }}<{{ name }}>{{< page }}{{/ rows }}";
+        context["rows"][3210]["page"] = "do-not-exists";
+        string expected = sequential.render(view, context);
+        REQUIRE(sequential.error() == "Cannot open file: ./test/fixtures/do-not-exists.mustache");
+
+        string res = parallel.render(view, context);
+        REQUIRE(parallel.error() == sequential.error());
+        REQUIRE(res == expected);
+    }
+}
+
+// Records the threads entering each section
+class SectionThreads : public RenderObserver {
+  public:
+    void sectionEnter(TokenKind, const string& name) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads_.push_back(std::make_pair(name, std::this_thread::get_id()));
+    }
+
+    vector<std::thread::id> threads(const string& name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        vector<std::thread::id> found;
+        for (const std::pair<string, std::thread::id>& entered : threads_) {
+            if (entered.first == name) {
+                found.push_back(entered.second);
+            }
+        }
+        return found;
+    }
+
+  private:
+    std::mutex mutex_;
+    vector<std::pair<string, std::thread::id> > threads_;
+};
+
+TEST_CASE("Parallel partials") {
+    EngineOptions options;
+    options.threads = 4;
+    options.parallelPartials = true;
+    Mustache parallel("./test/fixtures/", options);
+    Mustache sequential("./test/fixtures/");
+
+    SECTION("Same output of a sequential render") {
+        const char* files[] = {
+            "partials/simple", "partials/nested", "partials/with-variables",
+            "partials/multiple-partials-with-variables",
+            "partials/partial-inside-hidden-block", "templates/basic-template"
+        };
+        for (const char* file : files) {
+            string expected = sequential.renderFilenames(file, file);
+            REQUIRE(sequential.error().empty());
+            string res = parallel.renderFilenames(file, file);
+            REQUIRE(parallel.error().empty());
+            REQUIRE(res == expected);
+        }
+
+        // Partials used by nested partials rendered concurrently
+        Renderer renderer(parallel.engine());
+        const json context = json::parse(parallel.fileRead("partials/nested", "json"));
+        REQUIRE(renderer.render(*parallel.engine().load("partials/nested"), context));
+        vector<string> used = renderer.partials();
+        std::sort(used.begin(), used.end());
+        REQUIRE(used == vector<string>({ "partials/common/comment", "partials/common/doctype",
+                                         "partials/nested-1", "partials/nested-2",
+                                         "partials/nested-3" }));
+    }
+
+    json context;
+    for (unsigned i = 0; i < 200; ++i) {
+        context["rows"].push_back({ {"text", "row " + std::to_string(i)} });
+    }
+    context["text"] = "top";
+
+    SECTION("Partials inside sections and special variables") {
+        string view = "[{{> partials/common/text }}]"
+                "{{# rows }}{{# @first }}{{> partials/common/text }}|{{/ @first }}"
+                "{{ @index }}:{{> partials/common/text }};{{/ rows }}"
+                "[{{> partials/common/text }}]";
+        string expected = sequential.render(view, context);
+        REQUIRE(expected.find("[top\n]\n|0:row 0\n;1:row 1\n;") == 0);
+
+        string res = parallel.render(view, context);
+        REQUIRE(parallel.error().empty());
+        REQUIRE(res == expected);
+    }
+
+    SECTION("Partials inside array sections are rendered in place") {
+        EngineOptions observed = options;
+        const std::shared_ptr<SectionThreads> observer = std::make_shared<SectionThreads>();
+        observed.observer = observer;
+        observed.source = std::make_shared<mustache::MemorySource>(mustache::MemorySource::Files {
+            { "row.mustache", "{{= cell }}<{{ text }}>{{/ cell }}{{# dots }}.{{/ dots }}" }
+        });
+        Mustache mustache("./do-not-exists/", observed);
+        // Rows long enough for pool workers to take tasks, if any
+        for (json& row : context["rows"]) {
+            row["cell"] = true;
+            row["dots"] = vector<int>(1000, 0);
+        }
+        string res = mustache.render("{{# rows }}{{> row }}{{/ rows }}", context);
+        REQUIRE(mustache.error().empty());
+        REQUIRE(res.find("<row 0>" + string(1000, '.') + "<row 1>") == 0);
+
+        const vector<std::thread::id> cells = observer->threads("cell");
+        REQUIRE(cells.size() == context["rows"].size());
+        for (const std::thread::id& thread : cells) {
+            REQUIRE(thread == std::this_thread::get_id());
+        }
+    }
+
+    SECTION("The first error in document order wins") {
+        string view = "{{> partials/common/text }}{{# rows }}"
+                "{{> templates/basic-template }}{{/ rows }}{{> missing-too }}";
+        for (json& row : context["rows"]) {
+            row["header-to-open"] = "partials/common/doctype";
+            row["page-to-open"] = "partials/common/text";
+        }
+        context["rows"][120]["page-to-open"] = "do-not-exists";
+        context["rows"][150]["page-to-open"] = "missing";
+        string expected = sequential.render(view, context);
+        REQUIRE(sequential.error() == "Cannot open file: ./test/fixtures/do-not-exists.mustache");
+
+        string res = parallel.render(view, context);
+        REQUIRE(parallel.error() == sequential.error());
+        REQUIRE(res == expected);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
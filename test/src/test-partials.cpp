@@ -145,6 +145,11 @@ TEST_CASE("Partials") {
                 "partials/partial-inside-hidden-block");
         REQUIRE(res == expected);
         REQUIRE(m.error().empty());
+
+        // Partials inside hidden blocks are not loaded
+        m.render("{{# invisible }}{{> partials/common/doctype }}{{/ invisible }}", string("{}"));
+        REQUIRE(m.error().empty());
+        REQUIRE(!m.engine().find("partials/common/doctype"));
     }
 }
 
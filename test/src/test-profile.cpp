@@ -0,0 +1,186 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       test-profile.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache test suite (per-tag profiling).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include <catch2/catch.hpp>
+
+#include "../../src/mustache-light.hpp"
+using mustache::Engine;
+using mustache::EngineOptions;
+using mustache::Profile;
+using mustache::ProfileSite;
+using mustache::Renderer;
+using mustache::Template;
+using mustache::TemplatePtr;
+
+// The site of tag in file (nullptr if not profiled)
+static const ProfileSite* findSite(const vector<ProfileSite>& sites, const string& file,
+                                   const string& tag) {
+    for (const ProfileSite& site : sites) {
+        if (site.file == file && site.tag == tag) {
+            return &site;
+        }
+    }
+    return nullptr;
+}
+
+TEST_CASE("Profiling") {
+    const json context = {
+        { "title", "T" },
+        { "items", { { { "name", "a" } }, { { "name", "b" } } } }
+    };
+
+    SECTION("Positions of tokens") {
+        const Template view("a\n  {{# b }}\n{{ c }}");
+        REQUIRE(view.position(1).line == 2);
+        REQUIRE(view.position(1).column == 3);
+        REQUIRE(view.position(view.size() - 4).line == 3);
+        REQUIRE(view.position(view.size() - 4).column == 1);
+
+        Template::Tokens tokens = view.tokens();
+        const Template built(std::move(tokens));
+        REQUIRE(built.position(1).line == 0);
+    }
+
+    SECTION("Sites and folded stacks") {
+        const Engine engine("./test/fixtures/");
+        const TemplatePtr view = engine.compile(
+            "<h1>{{ title }}</h1>\n"
+            "{{# items }}{{> partials/common/user | Name=name | Surname='S' }}{{/ items }}");
+        Renderer renderer(engine);
+        Profile profile;
+        renderer.setProfile(&profile, "page");
+
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(renderer.render(*view, context));
+        }
+        REQUIRE(profile.renders() == 3);
+
+        const vector<ProfileSite> sites = profile.sites();
+        const ProfileSite* title = findSite(sites, "page", "{{ title }}");
+        REQUIRE(title != nullptr);
+        REQUIRE(title->count == 3);
+        REQUIRE(title->bytes == 3);
+        REQUIRE(title->line == 1);
+        REQUIRE(title->column == 5);
+
+        const ProfileSite* items = findSite(sites, "page", "{{# items }}");
+        REQUIRE(items != nullptr);
+        REQUIRE(items->count == 3);
+        REQUIRE(items->line == 2);
+        REQUIRE(items->bytes * 3 > renderer.output().size() * 2);
+        REQUIRE(items->time <= profile.time());
+
+        const ProfileSite* partial = findSite(
+            sites, "page", "{{> partials/common/user | Name=name | Surname='S' }}");
+        REQUIRE(partial != nullptr);
+        REQUIRE(partial->count == 6);
+        REQUIRE(partial->time <= items->time);
+
+        // Slowest first
+        for (std::size_t i = 1; i < sites.size(); ++i) {
+            REQUIRE(sites[i - 1].time >= sites[i].time);
+        }
+        REQUIRE(profile.report(1).find("{{# items }}") != string::npos);
+
+        const string folded = profile.foldedStacks();
+        REQUIRE(folded.find("page ") == 0);
+        REQUIRE(folded.find("\npage;partials/common/user|Name=name|Surname='S' ") != string::npos);
+
+        profile.clear();
+        REQUIRE(profile.renders() == 0);
+        REQUIRE(profile.sites().empty());
+        REQUIRE(profile.foldedStacks().empty());
+    }
+
+    SECTION("Different views with the default name") {
+        const Engine engine("./test/fixtures/");
+        Renderer renderer(engine);
+        Profile profile;
+        renderer.setProfile(&profile);
+
+        // Same number of tokens, different tags and positions
+        const TemplatePtr first = engine.compile("{{ title }}");
+        const TemplatePtr second = engine.compile("\n {{# items }}");
+        for (int i = 0; i < 2; ++i) {
+            REQUIRE(renderer.render(*first, context));
+            REQUIRE_FALSE(renderer.render(*second, context));
+        }
+        // The same text compiled again is the same template
+        REQUIRE(renderer.render(*engine.compile("{{ title }}"), context));
+
+        const vector<ProfileSite> sites = profile.sites();
+        const ProfileSite* title = findSite(sites, "(view)", "{{ title }}");
+        REQUIRE(title != nullptr);
+        REQUIRE(title->count == 3);
+        REQUIRE(title->line == 1);
+        REQUIRE(title->column == 1);
+        const ProfileSite* items = findSite(sites, "(view)", "{{# items }}");
+        REQUIRE(items != nullptr);
+        REQUIRE(items->count == 2);
+        REQUIRE(items->line == 2);
+        REQUIRE(items->column == 2);
+        REQUIRE(sites.size() == 2);
+    }
+
+    SECTION("Parallel renders are sequential while profiling") {
+        EngineOptions options;
+        options.threads = 4;
+        options.parallelPartials = true;
+        options.parallelSectionThreshold = 1;
+        const Engine engine("./test/fixtures/", options);
+        const TemplatePtr view = engine.compile(
+            "{{# items }}{{ name }}{{> partials/common/doctype }}{{/ items }}");
+        Renderer renderer(engine);
+        Profile profile;
+        renderer.setProfile(&profile);
+
+        REQUIRE(renderer.render(*view, context));
+        REQUIRE(renderer.output() == "a<!DOCTYPE html>b<!DOCTYPE html>");
+        const vector<ProfileSite> sites = profile.sites();
+        const ProfileSite* name = findSite(sites, "(view)", "{{ name }}");
+        REQUIRE(name != nullptr);
+        REQUIRE(name->count == 2);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
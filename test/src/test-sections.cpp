@@ -35,6 +35,8 @@
 
 #include <string>
 using std::string;
+#include <vector>
+using std::vector;
 
 #include <catch2/catch.hpp>
 
@@ -182,6 +184,40 @@ TEST_CASE("Sections") {
         REQUIRE(res == html);
         REQUIRE(m.error().empty());
     }
+
+    SECTION("Hidden sections are skipped") {
+        const string context = R"({"on": true, "off": false, "items": [1, 2]})";
+        // Nothing inside is evaluated: partials are not loaded
+        string res = m.render("a{{# off }}{{> do-not-exists }}{{# items }}x{{/ items }}{{/ off }}b"
+                              "{{^ on }}{{< missing-variable }}{{/ on }}c", context);
+        REQUIRE(m.error().empty());
+        REQUIRE(res == "abc");
+
+        res = m.render("{{# on }}[{{# off }}{{# on }}{{/ on }}{{/ off }}]{{/ on }}", context);
+        REQUIRE(m.error().empty());
+        REQUIRE(res == "[]");
+
+        // Section structure is still checked
+        m.render("{{# off }}{{# on }}{{/ on }}", context);
+        REQUIRE(m.error() == "Missing {{/");
+        m.render("{{# off }}{{/ on }}", context);
+        REQUIRE(m.error() == "Expected 'off' in closing block (found 'on')");
+
+        const mustache::Template view("{{# a }}{{= b }}{{/ b }}{{/ a }}{{^ c }}");
+        const mustache::Template::Tokens tokens = view.tokens();
+        vector<std::size_t> starts;
+        for (std::size_t i = 0; i < tokens.size(); ++i) {
+            if (tokens[i].kind == mustache::TokenKind::StartBeginSection ||
+                tokens[i].kind == mustache::TokenKind::StartIf ||
+                tokens[i].kind == mustache::TokenKind::StartUnless) {
+                starts.push_back(i);
+            }
+        }
+        REQUIRE(starts.size() == 3);
+        REQUIRE(tokens.at(view.sectionEnd(starts[0]) + 1).text == "a");
+        REQUIRE(tokens.at(view.sectionEnd(starts[1]) + 1).text == "b");
+        REQUIRE(view.sectionEnd(starts[2]) == view.size());
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
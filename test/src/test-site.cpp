@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       test-site.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache test suite (incremental site builds).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <algorithm>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <catch2/catch.hpp>
+
+#include "../../src/mustache-light.hpp"
+using mustache::Engine;
+using mustache::EngineOptions;
+using mustache::SiteBuilder;
+using mustache::SiteBuildResult;
+using mustache::SitePage;
+
+static void writeFile(const string& path, const string& contents) {
+    std::ofstream out(path.c_str(), std::ios::out | std::ios::trunc);
+    out << contents;
+}
+
+static string readFile(const string& path) {
+    std::ifstream in(path.c_str());
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+TEST_CASE("Incremental site build") {
+    const string base = "./mustache-test-site/";
+    ::mkdir(base.c_str(), 0700);
+    ::mkdir((base + "partials").c_str(), 0700);
+    writeFile(base + "page.mustache", "<{{> partials/header }}>{{ title }}{{< layout }}");
+    writeFile(base + "partials/header.mustache", "H");
+    writeFile(base + "partials/footer.mustache", "F");
+    writeFile(base + "partials/plain.mustache", "P");
+    writeFile(base + "a.json", R"({"title": "A", "layout": "partials/footer"})");
+    writeFile(base + "b.json", R"({"title": "B", "layout": "partials/plain"})");
+
+    const string state = base + "state.json";
+    const vector<SitePage> pages = {
+        { base + "out/a.html", "page", "a" },
+        { base + "out/b.html", "page", "b" }
+    };
+    // Each build uses a new engine, as a new process would
+    const auto build = [&](const vector<SitePage>& site) {
+        const Engine engine(base);
+        return SiteBuilder(engine, state).build(site, 2);
+    };
+
+    SiteBuildResult result = build(pages);
+    REQUIRE(result.rendered == 2);
+    REQUIRE(result.errors.empty());
+    REQUIRE(readFile(base + "out/a.html") == "<H>AF");
+    REQUIRE(readFile(base + "out/b.html") == "<H>BP");
+
+    result = build(pages);
+    REQUIRE(result.rendered == 0);
+    REQUIRE(result.skipped == 2);
+
+    // Dynamic templates are dependencies of the pages using them only
+    writeFile(base + "partials/footer.mustache", "F2");
+    result = build(pages);
+    REQUIRE(result.rendered == 1);
+    REQUIRE(readFile(base + "out/a.html") == "<H>AF2");
+
+    // Partials and contexts
+    writeFile(base + "partials/header.mustache", "H2");
+    writeFile(base + "b.json", R"({"title": "B2", "layout": "partials/plain"})");
+    result = build(pages);
+    REQUIRE(result.rendered == 2);
+    REQUIRE(readFile(base + "out/a.html") == "<H2>AF2");
+    REQUIRE(readFile(base + "out/b.html") == "<H2>B2P");
+
+    // Missing outputs
+    std::remove((base + "out/b.html").c_str());
+    result = build(pages);
+    REQUIRE(result.rendered == 1);
+    REQUIRE(readFile(base + "out/b.html") == "<H2>B2P");
+
+    // Failed pages are built again next time
+    writeFile(base + "b.json", R"({"title": "B3", "layout": "partials/missing"})");
+    result = build(pages);
+    REQUIRE(result.rendered == 0);
+    REQUIRE(result.skipped == 1);
+    REQUIRE(result.errors.size() == 1);
+    REQUIRE(result.errors[0].first == base + "out/b.html");
+    writeFile(base + "partials/missing.mustache", "M");
+    result = build(pages);
+    REQUIRE(result.rendered == 1);
+    REQUIRE(result.errors.empty());
+    REQUIRE(readFile(base + "out/b.html") == "<H2>B3M");
+
+    // A page changing template or context
+    result = build({ { base + "out/a.html", "page", "b" }, pages[1] });
+    REQUIRE(result.rendered == 1);
+    REQUIRE(readFile(base + "out/a.html") == "<H2>B3M");
+
+    for (const char* name : { "out/a.html", "out/b.html", "a.json", "b.json", "state.json",
+                              "page.mustache", "partials/header.mustache",
+                              "partials/footer.mustache", "partials/plain.mustache",
+                              "partials/missing.mustache" }) {
+        std::remove((base + name).c_str());
+    }
+    ::rmdir((base + "out").c_str());
+    ::rmdir((base + "partials").c_str());
+    ::rmdir(base.c_str());
+}
+
+TEST_CASE("Site build on the engine pool") {
+    const string base = "./mustache-test-site-pool/";
+    ::mkdir(base.c_str(), 0700);
+    string view = "[{{ title }}";
+    string expected = "[#";
+    for (int i = 0; i < 10; ++i) {
+        view += "{{> a }}{{> b }}{{> c }}";
+        expected += "(a #)(b #)(c #)";
+    }
+    writeFile(base + "page.mustache", view + "{{ title }}]");
+    expected += "#]";
+    for (const char* partial : { "a", "b", "c" }) {
+        writeFile(base + partial + ".mustache", string("(") + partial + " {{ title }})");
+    }
+    const unsigned contexts = 10;
+    for (unsigned i = 0; i < contexts; ++i) {
+        writeFile(base + std::to_string(i) + ".json", "{\"title\": \"" + std::to_string(i) + "\"}");
+    }
+
+    // Renders waiting for their partials build other pages meanwhile
+    EngineOptions options;
+    options.threads = 2;
+    options.parallelPartials = true;
+    const Engine engine(base, options);
+    vector<SitePage> pages;
+    for (unsigned i = 0; i < 2000; ++i) {
+        pages.push_back({ base + "out-" + std::to_string(i) + ".html", "page",
+                          std::to_string(i % contexts) });
+    }
+    unsigned mismatches = 0;
+    for (int build = 0; build < 5; ++build) {
+        std::remove((base + "state.json").c_str());
+        const SiteBuildResult result =
+                SiteBuilder(engine, base + "state.json").build(pages, *engine.pool());
+        REQUIRE(result.rendered == pages.size());
+        REQUIRE(result.errors.empty());
+        for (const SitePage& page : pages) {
+            string output = expected;
+            std::replace(output.begin(), output.end(), '#', page.context[0]);
+            if (readFile(page.output) != output) {
+                ++mismatches;
+            }
+            std::remove(page.output.c_str());
+        }
+    }
+    REQUIRE(mismatches == 0);
+
+    for (unsigned i = 0; i < contexts; ++i) {
+        std::remove((base + std::to_string(i) + ".json").c_str());
+    }
+    for (const char* name : { "page.mustache", "a.mustache", "b.mustache", "c.mustache",
+                              "state.json" }) {
+        std::remove((base + name).c_str());
+    }
+    ::rmdir(base.c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,236 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       test-sources.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache test suite (template sources).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+using std::string;
+#include <memory>
+#include <fstream>
+#include <cstdio>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include <catch2/catch.hpp>
+
+#include "../../src/mustache-light.hpp"
+using mustache::Engine;
+using mustache::EngineOptions;
+using mustache::RenderException;
+using mustache::Renderer;
+using mustache::Mustache;
+using mustache::WarmUpResult;
+#include <vector>
+using std::vector;
+
+static const char page[] = "<h1>{{ title }}</h1>\n{{> partials/item }}{{# items }}{{> partials/item }}{{/ items }}";
+static const char item[] = "<li>{{ name }}</li>";
+
+TEST_CASE("Template sources") {
+    const json context = json::parse(
+        R"({"title": "Users", "name": "Nobody", "items": [{"name": "Mario"}, {"name": "Luigi"}]})");
+    const string expected = "<h1>Users</h1>\n<li>Nobody</li><li>Mario</li><li>Luigi</li>";
+
+    SECTION("Memory source") {
+        EngineOptions options;
+        options.source = std::make_shared<mustache::MemorySource>(mustache::MemorySource::Files {
+            { "page.mustache", page },
+            { "partials/item.mustache", item },
+            { "page.json", context.dump() }
+        });
+        // Base path is not used by the source
+        Mustache mustache("./do-not-exists/", options);
+        REQUIRE(mustache.renderFilenames("page", "page") == expected);
+
+        Renderer renderer(mustache.engine());
+        REQUIRE(!renderer.render(*mustache.engine().compile("{{> partials/missing }}"), context));
+        REQUIRE(renderer.error() == "Cannot open file: partials/missing.mustache");
+        REQUIRE_THROWS_AS(mustache.engine().fileRead("missing", "json"), RenderException);
+    }
+
+    SECTION("Embedded source") {
+        static const mustache::EmbeddedFile files[] = {
+            { "page.mustache", page, sizeof(page) - 1 },
+            { "partials/item.mustache", item, sizeof(item) - 1 }
+        };
+        EngineOptions options;
+        options.source = std::make_shared<mustache::EmbeddedSource>(files, 2);
+        const Engine engine("", options);
+        Renderer renderer(engine);
+        REQUIRE(renderer.render(*engine.load("page"), context));
+        REQUIRE(renderer.output() == expected);
+
+        // Text outside tags points into the embedded data
+        const mustache::TemplatePtr compiled = engine.load("partials/item");
+        REQUIRE(compiled->data(0) == item);
+    }
+
+    SECTION("Directory source keeps file paths in errors") {
+        const Engine engine("./test/fixtures/");
+        REQUIRE(dynamic_cast<const mustache::DirectorySource*>(&engine.source()));
+        try {
+            engine.load("do-not-exists");
+            FAIL("File loaded");
+        } catch (const RenderException& e) {
+            REQUIRE(string(e.what()) == "Cannot open file: ./test/fixtures/do-not-exists.mustache");
+        }
+    }
+}
+
+TEST_CASE("Warm up") {
+    SECTION("All the templates are compiled and checked") {
+        EngineOptions options;
+        options.source = std::make_shared<mustache::MemorySource>(mustache::MemorySource::Files {
+            { "page.mustache", "{{# items }}{{> item | Name=name }}{{/ items }}" },
+            { "item.mustache", "<li>{{ Name }}</li>" },
+            { "broken/unclosed.mustache", "{{# items }}" },
+            { "broken/mismatch.mustache", "{{# a }}{{^ b }}{{/ a }}{{/ b }}" },
+            { "broken/tag.mustache", "{{ name }" },
+            { "broken/missing.mustache", "{{> do-not-exists }}" },
+            { "page.json", "{}" }
+        });
+        const Engine engine("", options);
+        const vector<WarmUpResult> results = engine.warmUp(2);
+        REQUIRE(results.size() == 6);
+        REQUIRE(results[0].fileName == "broken/mismatch");
+        REQUIRE(results[0].error == "Expected 'b' in closing block (found 'a')");
+        REQUIRE(results[1].fileName == "broken/missing");
+        REQUIRE(results[1].error == "Partial do-not-exists: Cannot open file: do-not-exists.mustache");
+        REQUIRE(results[2].error == "Unexpected end of file.");
+        REQUIRE(results[3].error == "Missing {{/ items");
+        REQUIRE(results[4].fileName == "item");
+        REQUIRE(results[4].error.empty());
+        REQUIRE(results[5].fileName == "page");
+        REQUIRE(results[5].error.empty());
+
+        // Files and partials with parameters are cached
+        REQUIRE(engine.find("page"));
+        REQUIRE(engine.find("item", { "Name=name" }));
+    }
+
+    SECTION("Template files in a directory") {
+        const Engine engine("./test/fixtures/");
+        const vector<WarmUpResult> results = engine.warmUp(2);
+        REQUIRE(results.size() > 10);
+        bool found = false;
+        for (const WarmUpResult& result : results) {
+            if (result.fileName == "partials/nested") {
+                REQUIRE(result.error.empty());
+                found = true;
+            }
+        }
+        REQUIRE(found);
+        REQUIRE(engine.find("partials/nested-1"));
+    }
+}
+
+TEST_CASE("Search path") {
+    const string base = "./mustache-test-layers/";
+    const char* files[][2] = {
+        { "tenant/partials/header.mustache", "Tenant header" },
+        { "theme/partials/header.mustache", "Theme header" },
+        { "theme/partials/footer.mustache", "Theme footer" },
+        { "base/partials/footer.mustache", "Base footer" },
+        { "base/page.mustache", "{{> partials/header }}|{{ title }}|{{> partials/footer }}" }
+    };
+    for (const char* dir : { "", "tenant", "tenant/partials", "theme", "theme/partials",
+                             "base", "base/partials" }) {
+        ::mkdir((base + dir).c_str(), 0700);
+    }
+    for (const auto& file : files) {
+        std::ofstream(base + file[0]) << file[1];
+    }
+
+    EngineOptions options;
+    Mustache mustache({ base + "tenant/", base + "theme/", base + "base/" }, options);
+    const json context = { { "title", "Title" } };
+    REQUIRE(mustache.render("{{> page }}", context) == "Tenant header|Title|Theme footer");
+
+    const mustache::SearchPathSource& source =
+        dynamic_cast<const mustache::SearchPathSource&>(mustache.engine().source());
+    REQUIRE(source.list("mustache") ==
+            vector<string>({ "page", "partials/footer", "partials/header" }));
+    REQUIRE(source.describe("partials/footer", "mustache") ==
+            base + "theme/partials/footer.mustache");
+    REQUIRE(source.describe("missing", "mustache") ==
+            "missing.mustache (searched in " + base + "tenant/, " + base + "theme/, " + base + "base/)");
+
+    // New files are found after a refresh
+    std::ofstream(base + "tenant/partials/footer.mustache") << "Tenant footer";
+    mustache::TemplateSource::Contents contents;
+    REQUIRE(source.read("partials/footer", "mustache", contents));
+    REQUIRE(string(contents.data, contents.size) == "Theme footer");
+    source.refresh();
+    REQUIRE(source.read("partials/footer", "mustache", contents));
+    REQUIRE(string(contents.data, contents.size) == "Tenant footer");
+
+    std::remove((base + "tenant/partials/footer.mustache").c_str());
+    for (const auto& file : files) {
+        std::remove((base + file[0]).c_str());
+    }
+    for (const char* dir : { "base/partials", "base", "theme/partials", "theme",
+                             "tenant/partials", "tenant", "" }) {
+        ::rmdir((base + dir).c_str());
+    }
+}
+
+TEST_CASE("Mustache caches template files") {
+    const string base = "./mustache-test-facade/";
+    ::mkdir(base.c_str(), 0700);
+    std::ofstream(base + "page.mustache") << "Page {{ title }} {{> part }}";
+    std::ofstream(base + "part.mustache") << "Part";
+    std::ofstream(base + "page.json") << R"({"title": "T"})";
+
+    Mustache mustache(base);
+    REQUIRE(mustache.renderFilenames("page", "page") == "Page T Part");
+
+    // Contexts are read on every call, templates are cached
+    std::ofstream(base + "page.mustache") << "New page {{ title }} {{> part }}";
+    std::ofstream(base + "part.mustache") << "New part";
+    std::ofstream(base + "page.json") << R"({"title": "T2"})";
+    REQUIRE(mustache.renderFilenames("page", "page") == "Page T2 Part");
+
+    mustache.clearCache();
+    REQUIRE(mustache.renderFilenames("page", "page") == "New page T2 New part");
+
+    for (const char* file : { "page.mustache", "part.mustache", "page.json" }) {
+        std::remove((base + file).c_str());
+    }
+    ::rmdir(base.c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       test-stats.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache test suite (render statistics).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+using std::string;
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include <catch2/catch.hpp>
+
+#include "../../src/mustache-light.hpp"
+using mustache::Mustache;
+using mustache::EngineOptions;
+using mustache::RenderStats;
+using mustache::TokenKind;
+
+TEST_CASE("Render statistics") {
+    const json context = {
+        { "items", { { { "name", "<a>" } }, { { "name", "b" } }, { { "name", "c" } } } },
+        { "off", false }
+    };
+
+    SECTION("Tags, lookups and escapes") {
+        Mustache m("./test/fixtures/");
+        RenderStats stats;
+        m.setStats(&stats);
+
+        const string res = m.render("<ul>{{# items }}<li>{{ name }}</li>{{/ items }}</ul>"
+                                    "{{ missing }}{{# off }}{{ hidden }}{{/ off }}", context);
+        REQUIRE(m.error().empty());
+        REQUIRE(res == "<ul><li>&lt;a&gt;</li><li>b</li><li>c</li></ul>");
+        REQUIRE(stats.tags(TokenKind::StartBeginSection) == 2);
+        REQUIRE(stats.tags(TokenKind::StartVariable) == 4);
+        REQUIRE(stats.escapes == 3);
+        // items, name x 3, missing, off
+        REQUIRE(stats.lookups == 6);
+        REQUIRE(stats.misses == 1);
+        REQUIRE(stats.maxStackDepth == 2);
+        REQUIRE(stats.bytesEmitted == res.size());
+        REQUIRE(stats.tokens > 0);
+        REQUIRE(stats.partialHits + stats.partialMisses == 0);
+        REQUIRE(stats.renderTime.count() > 0);
+        REQUIRE(stats.tokenizeTime.count() > 0);
+
+        // Each render starts again from zero
+        m.render(string("{{ a }}"), string("{\"a\": 1}"));
+        REQUIRE(stats.lookups == 1);
+        REQUIRE(stats.escapes == 0);
+        REQUIRE(stats.parseContextTime.count() > 0);
+
+        // Disabled: the last statistics are left as they are
+        m.setStats(nullptr);
+        m.render("{{ a }}{{ a }}", context);
+        REQUIRE(stats.lookups == 1);
+    }
+
+    SECTION("Partials") {
+        Mustache m("./test/fixtures/");
+        RenderStats stats;
+        m.setStats(&stats);
+
+        const string view = "{{> partials/common/doctype }}{{> partials/common/doctype }}";
+        m.render(view, context);
+        REQUIRE(m.error().empty());
+        REQUIRE(stats.partialMisses == 1);
+        REQUIRE(stats.partialHits == 1);
+        REQUIRE(stats.bytesRead == 15);
+
+        m.render(view, context);
+        REQUIRE(stats.partialMisses == 0);
+        REQUIRE(stats.partialHits == 2);
+        REQUIRE(stats.bytesRead == 0);
+    }
+
+    SECTION("Parallel renders are included") {
+        const string view = "{{# items }}{{> partials/common/doctype }}{{ name }}{{/ items }}";
+        RenderStats sequential;
+        Mustache m("./test/fixtures/");
+        m.setStats(&sequential);
+        const string expected = m.render(view, context);
+
+        EngineOptions options;
+        options.threads = 4;
+        options.parallelPartials = true;
+        options.parallelSectionThreshold = 2;
+        RenderStats parallel;
+        Mustache p("./test/fixtures/", options);
+        p.setStats(&parallel);
+        REQUIRE(p.render(view, context) == expected);
+        REQUIRE(p.error().empty());
+        REQUIRE(parallel.tags(TokenKind::StartPartial) == sequential.tags(TokenKind::StartPartial));
+        REQUIRE(parallel.lookups == sequential.lookups);
+        REQUIRE(parallel.escapes == sequential.escapes);
+        REQUIRE(parallel.maxStackDepth == sequential.maxStackDepth);
+        REQUIRE(parallel.partialHits + parallel.partialMisses == 3);
+        REQUIRE(parallel.bytesEmitted == expected.size());
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
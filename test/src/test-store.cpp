@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       test-store.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache test suite (shared template store).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <cstdio>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include <catch2/catch.hpp>
+
+#include "../../src/mustache-light.hpp"
+using mustache::Engine;
+using mustache::EngineOptions;
+using mustache::RenderException;
+using mustache::Renderer;
+using mustache::TemplateStore;
+using mustache::TemplateStorePtr;
+
+TEST_CASE("Shared template store") {
+    const Engine files("./test/fixtures/");
+    const string path = "./mustache-test-store.tmp";
+    const vector<string> names = {
+        "partials/nested", "partials/nested-1", "partials/nested-2",
+        "partials/nested-3", "partials/common/doctype", "partials/common/comment",
+        "partials/common/user", "partials/multiple-partials-with-variables"
+    };
+    TemplateStore::write(path, files, names);
+
+    SECTION("Templates are the same of compiled files") {
+        const TemplateStorePtr store = TemplateStore::open(path);
+        REQUIRE(store->names().size() == names.size());
+        REQUIRE(store->find("partials/do-not-exists") == nullptr);
+        for (const string& name : names) {
+            const mustache::TemplatePtr stored = store->find(name);
+            const mustache::TemplatePtr compiled = files.load(name);
+            REQUIRE(stored);
+            const mustache::Template::Tokens tokens = compiled->tokens();
+            REQUIRE(stored->size() == compiled->size());
+            for (std::size_t i = 0; i < stored->size(); ++i) {
+                REQUIRE(stored->kind(i) == compiled->kind(i));
+                REQUIRE(string(stored->data(i), stored->length(i)) == tokens.at(i).text);
+                if (stored->isTag(i)) {
+                    REQUIRE(stored->text(i) == compiled->text(i));
+                }
+            }
+        }
+    }
+
+    SECTION("Renders without reading template files") {
+        EngineOptions options;
+        options.store = TemplateStore::open(path);
+        // Any file read would fail
+        const Engine engine("./do-not-exists/", options);
+        Renderer expected(files);
+        Renderer renderer(engine);
+        for (const char* name : { "partials/nested", "partials/multiple-partials-with-variables" }) {
+            const json context = json::parse(files.fileRead(name, "json"));
+            REQUIRE(expected.render(*files.load(name), context));
+            REQUIRE(renderer.render(*engine.load(name), context));
+            REQUIRE(renderer.output() == expected.output());
+        }
+    }
+
+    SECTION("Templates keep the store mapped") {
+        mustache::TemplatePtr stored;
+        {
+            const TemplateStorePtr store = TemplateStore::open(path);
+            stored = store->find("partials/common/user");
+        }
+        std::remove(path.c_str());
+        REQUIRE(string(stored->data(0), stored->length(0)) == files.load("partials/common/user")->tokens().at(0).text);
+    }
+
+    SECTION("Templates are built once") {
+        const TemplateStorePtr store = TemplateStore::open(path);
+        const mustache::TemplatePtr first = store->find("partials/common/user");
+        REQUIRE(store->find("partials/common/user") == first);
+        store->build();
+        REQUIRE(store->find("partials/common/user") == first);
+    }
+
+    SECTION("Invalid stores") {
+        REQUIRE_THROWS_AS(TemplateStore::open("./do-not-exists"), RenderException);
+        std::ofstream(path.c_str(), std::ios::out | std::ios::trunc) << "Not a template store";
+        REQUIRE_THROWS_AS(TemplateStore::open(path), RenderException);
+    }
+
+    std::remove(path.c_str());
+}
+
+
+TEST_CASE("Mapped template files") {
+    const Engine files("./test/fixtures/");
+    EngineOptions options;
+    options.mapFiles = true;
+    const Engine mapped("./test/fixtures/", options);
+
+    SECTION("Same output of read files") {
+        Renderer expected(files);
+        Renderer renderer(mapped);
+        for (const char* name : { "partials/nested", "partials/multiple-partials-with-variables",
+                                  "templates/basic-template", "sections/list-with-indexes" }) {
+            const json context = json::parse(files.fileRead(name, "json"));
+            REQUIRE(expected.render(*files.load(name), context));
+            REQUIRE(renderer.render(*mapped.load(name), context));
+            REQUIRE(renderer.output() == expected.output());
+        }
+        REQUIRE_THROWS_AS(mapped.load("do-not-exists"), RenderException);
+    }
+
+    SECTION("Views not terminated by a null character") {
+        const char* views[] = {
+            "", "text", "{{", "{{#", "{{ a }", "a}}", "{{ a }}}", "{ {{ a }} }",
+            "x{{{ a }}}y{{> b }}", "{{/ a", "}"
+        };
+        for (const char* view : views) {
+            const string text = view;
+            // Exactly sized copy
+            const std::shared_ptr<vector<char> > buffer =
+                std::make_shared<vector<char> >(text.begin(), text.end());
+            const mustache::Template owned(text);
+            const mustache::Template external(buffer->empty() ? nullptr : &(*buffer)[0],
+                                              buffer->size(), buffer);
+            const mustache::Template::Tokens expected = owned.tokens();
+            const mustache::Template::Tokens tokens = external.tokens();
+            REQUIRE(tokens.size() == expected.size());
+            for (std::size_t i = 0; i < tokens.size(); ++i) {
+                REQUIRE(tokens[i].kind == expected[i].kind);
+                REQUIRE(tokens[i].text == expected[i].text);
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
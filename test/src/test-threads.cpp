@@ -0,0 +1,231 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       test-threads.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache test suite (engine shared by many threads).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <thread>
+#include <atomic>
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include <catch2/catch.hpp>
+
+#include "../../src/mustache-light.hpp"
+using mustache::Engine;
+using mustache::Renderer;
+using mustache::TemplateCache;
+using mustache::TemplatePtr;
+
+TEST_CASE("Engine shared by many threads") {
+    const Engine engine("./test/fixtures/");
+
+    // View and context file names
+    const char* fixtures[][2] = {
+        { "partials/nested", "partials/nested" },
+        { "partials/multiple-partials-with-variables", "partials/multiple-partials-with-variables" },
+        { "partials/partial-inside-hidden-block", "partials/partial-inside-hidden-block" },
+        { "sections/list-with-indexes", "sections/list-with-indexes" },
+        { "templates/basic-template", "templates/basic-template" }
+    };
+    const std::size_t fixtureCount = sizeof(fixtures) / sizeof(fixtures[0]);
+    const unsigned threadCount = 8;
+    const unsigned iterations = 50;
+
+    // Render everything once, sequentially
+    vector<json> contexts;
+    vector<string> expected;
+    Renderer renderer(engine);
+    for (std::size_t i = 0; i < fixtureCount; ++i) {
+        contexts.push_back(json::parse(engine.fileRead(fixtures[i][1], "json")));
+        REQUIRE(renderer.render(*engine.load(fixtures[i][0]), contexts.back()));
+        expected.push_back(renderer.output());
+    }
+
+    SECTION("Same results from all the threads") {
+        std::atomic<unsigned> failures(0);
+        vector<std::thread> threads;
+        for (unsigned t = 0; t < threadCount; ++t) {
+            threads.push_back(std::thread([&]() {
+                Renderer threadRenderer(engine);
+                for (unsigned i = 0; i < iterations; ++i) {
+                    const std::size_t f = i % fixtureCount;
+                    if (!threadRenderer.render(*engine.load(fixtures[f][0]), contexts.at(f)) ||
+                        threadRenderer.output() != expected.at(f)) {
+                        ++failures;
+                    }
+                }
+            }));
+        }
+        for (std::size_t t = 0; t < threads.size(); ++t) {
+            threads.at(t).join();
+        }
+        REQUIRE(failures == 0);
+    }
+
+    SECTION("Cache cleared while rendering") {
+        std::atomic<unsigned> failures(0);
+        std::atomic<bool> done(false);
+        std::thread cleaner([&]() {
+            while (!done) {
+                engine.clearCache();
+                std::this_thread::yield();
+            }
+        });
+        vector<std::thread> threads;
+        for (unsigned t = 0; t < threadCount; ++t) {
+            threads.push_back(std::thread([&]() {
+                Renderer threadRenderer(engine);
+                for (unsigned i = 0; i < iterations; ++i) {
+                    const std::size_t f = i % fixtureCount;
+                    if (!threadRenderer.render(*engine.load(fixtures[f][0]), contexts.at(f)) ||
+                        threadRenderer.output() != expected.at(f)) {
+                        ++failures;
+                    }
+                }
+            }));
+        }
+        for (std::size_t t = 0; t < threads.size(); ++t) {
+            threads.at(t).join();
+        }
+        done = true;
+        cleaner.join();
+        REQUIRE(failures == 0);
+    }
+
+    SECTION("Templates reloaded and evicted while rendering") {
+        std::atomic<unsigned> failures(0);
+        std::atomic<bool> done(false);
+        std::thread writer([&]() {
+            for (unsigned i = 0; !done; ++i) {
+                const std::size_t f = i % fixtureCount;
+                if (i % 2 == 0) {
+                    engine.reload(fixtures[f][0]);
+                } else {
+                    engine.evict("partials/common/user");
+                }
+                std::this_thread::yield();
+            }
+        });
+        vector<std::thread> threads;
+        for (unsigned t = 0; t < threadCount; ++t) {
+            threads.push_back(std::thread([&]() {
+                Renderer threadRenderer(engine);
+                for (unsigned i = 0; i < iterations; ++i) {
+                    const std::size_t f = i % fixtureCount;
+                    if (!threadRenderer.render(*engine.load(fixtures[f][0]), contexts.at(f)) ||
+                        threadRenderer.output() != expected.at(f)) {
+                        ++failures;
+                    }
+                }
+            }));
+        }
+        for (std::size_t t = 0; t < threads.size(); ++t) {
+            threads.at(t).join();
+        }
+        done = true;
+        writer.join();
+        REQUIRE(failures == 0);
+    }
+}
+
+TEST_CASE("Template cache") {
+    const Engine engine("./test/fixtures/");
+    TemplateCache cache;
+    const TemplatePtr first = engine.compile("first");
+    const TemplatePtr second = engine.compile("second");
+
+    SECTION("Insert keeps the cached template") {
+        REQUIRE(cache.insert("a", first) == first);
+        REQUIRE(cache.insert("a", second) == first);
+        REQUIRE(cache.find("a") == first);
+        REQUIRE(cache.find("b") == nullptr);
+        cache.replace("a", second);
+        REQUIRE(cache.find("a") == second);
+        REQUIRE(cache.size() == 1);
+    }
+
+    SECTION("Erase") {
+        cache.insert("user", first);
+        cache.insert("user|Name='Mario'", first);
+        cache.insert("user|Name='John'", first);
+        cache.insert("users", first);
+        cache.erasePrefix("user|");
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.find("user|Name='Mario'") == nullptr);
+        cache.erase("user");
+        REQUIRE(cache.find("user") == nullptr);
+        REQUIRE(cache.find("users") == first);
+        cache.clear();
+        REQUIRE(cache.size() == 0);
+    }
+
+    SECTION("Lookups while writers publish") {
+        const unsigned readerCount = 8;
+        std::atomic<unsigned> failures(0);
+        std::atomic<bool> done(false);
+        cache.insert("stable", first);
+        vector<std::thread> threads;
+        for (unsigned t = 0; t < readerCount; ++t) {
+            threads.push_back(std::thread([&]() {
+                while (!done) {
+                    if (cache.find("stable") != first) {
+                        ++failures;
+                    }
+                    const TemplatePtr changing = cache.find("changing");
+                    if (changing && changing != first && changing != second) {
+                        ++failures;
+                    }
+                }
+            }));
+        }
+        for (unsigned i = 0; i < 2000; ++i) {
+            cache.replace("changing", i % 2 == 0 ? first : second);
+            if (i % 3 == 0) {
+                cache.erase("changing");
+            }
+        }
+        done = true;
+        for (std::size_t t = 0; t < threads.size(); ++t) {
+            threads.at(t).join();
+        }
+        REQUIRE(failures == 0);
+        REQUIRE(first->tokens().at(0).text == "first");
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
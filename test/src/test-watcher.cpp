@@ -0,0 +1,194 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file       test-watcher.cpp
+/// @author     Xelia snc <info@xelia.it>
+/// @copyright  The code is licensed under the MIT License.
+///
+///             <http://opensource.org/licenses/MIT>:
+///
+///             Copyright (c) Xelia snc
+///
+///             Permission is hereby granted, free of charge, to any person
+///             obtaining a copy of this software and associated documentation
+///             files (the "Software"), to deal in the Software without
+///             restriction, including without limitation the rights to use,
+///             copy, modify, merge, publish, distribute, sublicense, and/or
+///             sell copies of the Software, and to permit persons to whom
+///             the Software is furnished to do so, subject to the following
+///             conditions:
+///
+///             The above copyright notice and this permission notice shall be
+///             included in all copies or substantial portions of the Software.
+///
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+///             EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+///             OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+///             NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+///             HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+///             WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+///             ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+///             THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// @brief      Mustache test suite (hot reload of templates).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+using std::string;
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <fstream>
+#include <cstdio>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include <catch2/catch.hpp>
+
+#include "../../src/mustache-light.hpp"
+using mustache::Engine;
+using mustache::EngineOptions;
+using mustache::MemorySource;
+using mustache::Renderer;
+using mustache::SearchPathSource;
+using mustache::TemplateWatcher;
+
+static void writeFile(const string& path, const string& contents) {
+    std::ofstream out(path.c_str(), std::ios::out | std::ios::trunc);
+    out << contents;
+}
+
+// Waits up to 5 seconds for a condition
+static bool eventually(const std::function<bool()>& condition) {
+    for (int i = 0; i < 500 && !condition(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+TEST_CASE("Hot reload of templates") {
+    const string base = "./mustache-test-watch/";
+    ::mkdir(base.c_str(), 0700);
+    ::mkdir((base + "partials").c_str(), 0700);
+    writeFile(base + "page.mustache", "<{{> partials/name | who=name }}>");
+    writeFile(base + "partials/name.mustache", "Hello {{ who }}");
+    // Linked directories are watched like the index of the source sees
+    // them (their entries have no directory type)
+    const string linked = "./mustache-test-watch-linked/";
+    ::mkdir(linked.c_str(), 0700);
+    writeFile(linked + "item.mustache", "A");
+    std::remove((base + "linked").c_str());
+    REQUIRE(::symlink("../mustache-test-watch-linked", (base + "linked").c_str()) == 0);
+
+    const Engine engine(base);
+    const json context = { {"name", "Mario"} };
+    Renderer renderer(engine);
+    REQUIRE(renderer.render(*engine.load("page"), context));
+    REQUIRE(renderer.output() == "<Hello Mario>");
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    string last;
+    {
+        TemplateWatcher watcher(engine, [&](const string& fileName) {
+            std::lock_guard<std::mutex> lock(mutex);
+            last = fileName;
+            changed.notify_all();
+        });
+        const auto waitFor = [&](const string& fileName) {
+            std::unique_lock<std::mutex> lock(mutex);
+            const bool seen = changed.wait_for(lock, std::chrono::seconds(5),
+                                               [&]() { return last == fileName; });
+            last.clear();
+            return seen;
+        };
+
+        // A partial with parameters is made again from the new file
+        writeFile(base + "partials/name.mustache", "Bye {{ who }}");
+        REQUIRE(waitFor("partials/name"));
+        REQUIRE(renderer.render(*engine.load("page"), context));
+        REQUIRE(renderer.output() == "<Bye Mario>");
+
+        // Files replaced by renaming, like editors do
+        writeFile(base + "page.tmp", "[{{> partials/name | who=name }}]");
+        REQUIRE(std::rename((base + "page.tmp").c_str(), (base + "page.mustache").c_str()) == 0);
+        REQUIRE(waitFor("page"));
+        REQUIRE(renderer.render(*engine.load("page"), context));
+        REQUIRE(renderer.output() == "[Bye Mario]");
+
+        // New directories are watched too (files may be seen while
+        // they are written: wait for the final version)
+        ::mkdir((base + "new").c_str(), 0700);
+        writeFile(base + "new/one.mustache", "1");
+        REQUIRE(eventually([&]() { return engine.load("new/one")->tokens().at(0).text == "1"; }));
+        writeFile(base + "new/one.mustache", "2");
+        REQUIRE(eventually([&]() { return engine.load("new/one")->tokens().at(0).text == "2"; }));
+
+        // Removed files are evicted
+        std::remove((base + "new/one.mustache").c_str());
+        REQUIRE(eventually([&]() { return engine.find("new/one") == nullptr; }));
+
+        REQUIRE(engine.load("linked/item")->tokens().at(0).text == "A");
+        writeFile(linked + "item.mustache", "B");
+        REQUIRE(eventually([&]() { return engine.load("linked/item")->tokens().at(0).text == "B"; }));
+    }
+
+    std::remove((base + "linked").c_str());
+    std::remove((linked + "item.mustache").c_str());
+    ::rmdir(linked.c_str());
+
+    std::remove((base + "partials/name.mustache").c_str());
+    std::remove((base + "page.mustache").c_str());
+    ::rmdir((base + "new").c_str());
+    ::rmdir((base + "partials").c_str());
+    ::rmdir(base.c_str());
+}
+
+TEST_CASE("Hot reload of a search path") {
+    const string base = "./mustache-test-watch-path/";
+    const string tenant = base + "tenant/";
+    const string shared = base + "shared/";
+    ::mkdir(base.c_str(), 0700);
+    ::mkdir(tenant.c_str(), 0700);
+    ::mkdir(shared.c_str(), 0700);
+    writeFile(shared + "page.mustache", "shared");
+
+    EngineOptions options;
+    options.source = std::make_shared<SearchPathSource>(std::vector<string>({ tenant, shared }));
+    const Engine engine(tenant, options);
+    REQUIRE(engine.load("page")->tokens().at(0).text == "shared");
+    {
+        TemplateWatcher watcher(engine);
+
+        // Every root is watched, not only the first one
+        writeFile(shared + "page.mustache", "shared 2");
+        REQUIRE(eventually([&]() { return engine.load("page")->tokens().at(0).text == "shared 2"; }));
+
+        // An override added to the first root replaces the cached template
+        writeFile(tenant + "page.mustache", "tenant");
+        REQUIRE(eventually([&]() { return engine.load("page")->tokens().at(0).text == "tenant"; }));
+
+        // Removing it falls back to the shared one
+        std::remove((tenant + "page.mustache").c_str());
+        REQUIRE(eventually([&]() { return engine.load("page")->tokens().at(0).text == "shared 2"; }));
+    }
+
+    // Sources without directories cannot be watched
+    EngineOptions memory;
+    memory.source = std::make_shared<MemorySource>(MemorySource::Files());
+    const Engine inMemory("", memory);
+    REQUIRE_THROWS_AS(TemplateWatcher(inMemory), mustache::RenderException);
+
+    std::remove((shared + "page.mustache").c_str());
+    ::rmdir(tenant.c_str());
+    ::rmdir(shared.c_str());
+    ::rmdir(base.c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////